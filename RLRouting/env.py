@@ -242,7 +242,11 @@ class CreateEnviroment(object):
                 break
             agent_ID_string = "agent_{0}".format(agentID)
             mask_string = "mask_{0}{1}{2}{3}".format(key_mask[0],key_mask[1],key_mask[2],key_mask[3])
-            state = Graph_data_construction(list(obs[1:]), request_actions, actual_actions)
+            if len(obs) == 3:
+                # node and edge features built by the simulator
+                state = Graph_data_from_buffers(obs[1], obs[2], actual_actions)
+            else:
+                state = Graph_data_construction(list(obs[1:]), request_actions, actual_actions)
             act = self.Networks.get_action(state[0], state[1])
             self.action = self.env.action_space.sample()
             self.action['AgentID'][0] = agentID
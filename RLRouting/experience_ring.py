@@ -0,0 +1,102 @@
+# * -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+# *
+# * Copyright (c) 2023 UCAS China
+# *
+# * This program is free software; you can redistribute it and/or modify
+# * it under the terms of the GNU General Public License version 2 as
+# * published by the Free Software Foundation;
+# *
+# * This program is distributed in the hope that it will be useful,
+# * but WITHOUT ANY WARRANTY; without even the implied warranty of
+# * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# * GNU General Public License for more details.
+# *
+# * You should have received a copy of the GNU General Public License
+# * along with this program; if not, write to the Free Software
+# * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+# *
+# * Author: HaiLong Su
+# *
+'''
+Reader of the shared memory experience ring written by ExperienceRingBuffer
+(model/experience-ring-buffer.h), so that a learner can train at its own pace
+while the simulator keeps stepping. Layout must match the C++ side.
+'''
+import mmap
+import os
+import struct
+import numpy as np
+import torch
+from utils import Graph_data_construction
+
+RING_MAGIC = 0x50584C52
+RING_VERSION = 1
+HEADER_SIZE = 192
+HEAD_OFFSET = 64
+TAIL_OFFSET = 128
+FEATURE_SIZE = 56
+
+
+class ExperienceRing(object):
+    # Map /dev/shm/<name> created by the simulator (config key rl_experience_ring_name)
+    def __init__(self, name):
+        self.path = os.path.join('/dev/shm', name.lstrip('/'))
+        fd = os.open(self.path, os.O_RDWR)
+        try:
+            self.buffer = mmap.mmap(fd, 0, mmap.MAP_SHARED, mmap.PROT_READ | mmap.PROT_WRITE)
+        finally:
+            os.close(fd)
+        magic, version, self.record_size, self.capacity, self.state_dim = \
+            struct.unpack_from('<5I', self.buffer, 0)
+        if magic != RING_MAGIC or version != RING_VERSION:
+            raise RuntimeError("{0} is not an experience ring of version {1}".format(self.path, RING_VERSION))
+        self.dtype = np.dtype({
+            'names': ['node', 'action', 'time', 'reward', 'mask', 'probability', 'state'],
+            'formats': ['<u4', '<u4', '<i8', '<f4', ('u1', 4), ('<f4', 4), ('<f4', self.state_dim)],
+            'offsets': [0, 4, 8, 16, 20, 24, 40],
+            'itemsize': self.record_size})
+        self.records = np.frombuffer(self.buffer, dtype=self.dtype, count=self.capacity, offset=HEADER_SIZE)
+        # last (state, probability) per agent and mask, as kept by env.py
+        self.last = dict()
+
+    def head(self):
+        return struct.unpack_from('<Q', self.buffer, HEAD_OFFSET)[0]
+
+    def tail(self):
+        return struct.unpack_from('<Q', self.buffer, TAIL_OFFSET)[0]
+
+    def drain(self, max_records=4096):
+        '''copy out the published records and hand their slots back to the simulator'''
+        tail = self.tail()
+        count = min(self.head() - tail, max_records)
+        index = (np.arange(tail, tail + count) & (self.capacity - 1)).astype(np.int64)
+        batch = self.records[index].copy()
+        struct.pack_into('<Q', self.buffer, TAIL_OFFSET, tail + count)
+        return batch
+
+    def drain_to_replay_memory(self, replay_memory, max_records=4096):
+        '''turn consecutive queries of the same agent and mask into experiences, like env.py does online'''
+        pushed = 0
+        for record in self.drain(max_records):
+            mask = [int(m) for m in record['mask']]
+            request_actions = [1 if m == 1 or m == 3 else 0 for m in mask]
+            actual_actions = [1 if m >= 2 else 0 for m in mask]
+            obs = record['state'].reshape(5, FEATURE_SIZE).tolist()
+            state = Graph_data_construction(obs, request_actions, actual_actions)
+            act = torch.FloatTensor(record['probability'])
+            key = (int(record['node']), tuple(mask))
+            if key in self.last:
+                last_state, last_act = self.last[key]
+                reward = float(record['reward'])
+                replay_memory.push(reward, last_state, last_act, state, reward, 0)
+                pushed += 1
+            self.last[key] = (state, act)
+        return pushed
+
+    def close(self):
+        self.records = None
+        self.buffer.close()
+
+    def unlink(self):
+        '''remove the segment once the simulation has finished and the ring is drained'''
+        os.unlink(self.path)
@@ -0,0 +1,55 @@
+# * -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+# *
+# * Copyright (c) 2023 UCAS China
+# *
+# * This program is free software; you can redistribute it and/or modify
+# * it under the terms of the GNU General Public License version 2 as
+# * published by the Free Software Foundation;
+# *
+# * This program is distributed in the hope that it will be useful,
+# * but WITHOUT ANY WARRANTY; without even the implied warranty of
+# * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# * GNU General Public License for more details.
+# *
+# * You should have received a copy of the GNU General Public License
+# * along with this program; if not, write to the Free Software
+# * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+# *
+# * Author: HaiLong Su
+# *
+'''
+Reader of the binned ISL utilization written by IslUtilizationRecorder
+(model/isl-utilization-recorder.h). The counters are memory mapped, so a
+heatmap of all links only touches the pages it plots. Layout must match the
+C++ side.
+'''
+import struct
+import numpy as np
+
+MAGIC = 0x49534C55
+VERSION = 1
+HEADER_SIZE = 32
+
+
+def read_isl_utilization(path):
+    '''
+    :return: bin width in ns, (links, 2) array of (from, to) node ids,
+             (links, bins) bytes and (links, bins) packets, both memory mapped
+    '''
+    with open(path, 'rb') as f:
+        magic, version, num_links, num_bins, bin_width_ns = struct.unpack('<IIIIq', f.read(24))
+    if magic != MAGIC or version != VERSION:
+        raise ValueError('%s is not an ISL utilization file of version %d' % (path, VERSION))
+    links = np.memmap(path, dtype='<u4', mode='r', offset=HEADER_SIZE, shape=(num_links, 2))
+    offset = HEADER_SIZE + num_links * 2 * 4
+    byte_counts = np.memmap(path, dtype='<u4', mode='r', offset=offset, shape=(num_links, num_bins))
+    offset += num_links * num_bins * 4
+    packet_counts = np.memmap(path, dtype='<u4', mode='r', offset=offset, shape=(num_links, num_bins))
+    return bin_width_ns, links, byte_counts, packet_counts
+
+
+def utilization(byte_counts, bin_width_ns, data_rate_bps):
+    '''
+    :return: fraction of the link capacity used in every bin
+    '''
+    return byte_counts * 8.0 / (data_rate_bps * bin_width_ns * 1e-9)
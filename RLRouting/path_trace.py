@@ -0,0 +1,60 @@
+# * -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+# *
+# * Copyright (c) 2023 UCAS China
+# *
+# * This program is free software; you can redistribute it and/or modify
+# * it under the terms of the GNU General Public License version 2 as
+# * published by the Free Software Foundation;
+# *
+# * This program is distributed in the hope that it will be useful,
+# * but WITHOUT ANY WARRANTY; without even the implied warranty of
+# * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# * GNU General Public License for more details.
+# *
+# * You should have received a copy of the GNU General Public License
+# * along with this program; if not, write to the Free Software
+# * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+# *
+# * Author: HaiLong Su
+# *
+'''
+Reader of the sampled packet paths written by PathTracer (model/path-tracer.h).
+Layout must match the C++ side.
+'''
+import socket
+import struct
+from collections import defaultdict
+
+MAGIC = 0x50415448
+VERSION = 1
+KINDS = ('approach', 'away', 'drop', 'rl_chosen', 'static')
+DIRECTIONS = ('north', 'south', 'west', 'east')
+HOP = struct.Struct('<QqIBBH')
+
+
+def read_path_trace(path):
+    '''
+    :return: list of flows, each a dict with source, destination, overwritten and
+             paths mapping a packet uid to its hops (time ns, satellite, kind, direction)
+    '''
+    with open(path, 'rb') as f:
+        data = f.read()
+    magic, version, num_flows, sample_one_in = struct.unpack_from('<IIII', data, 0)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError('%s is not a path trace of version %d' % (path, VERSION))
+    offset = 16
+    flows = []
+    for _ in range(num_flows):
+        source, destination, kept, overwritten = struct.unpack_from('<IIII', data, offset)
+        offset += 16
+        paths = defaultdict(list)
+        for _ in range(kept):
+            uid, time_ns, satellite, kind, direction, _padding = HOP.unpack_from(data, offset)
+            offset += HOP.size
+            paths[uid].append((time_ns, satellite, KINDS[kind],
+                               DIRECTIONS[direction] if direction < 4 else 'cross_shell_%d' % (direction - 4)))
+        flows.append({'source': socket.inet_ntoa(struct.pack('>I', source)),
+                      'destination': socket.inet_ntoa(struct.pack('>I', destination)),
+                      'overwritten': overwritten,
+                      'paths': dict(paths)})
+    return flows
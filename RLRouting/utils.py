@@ -136,4 +136,13 @@ def Graph_data_construction(obs, mask_request, mask_actual):
     return (state, mask_actual)
 
 
+def Graph_data_from_buffers(node_features, edge_features, mask_actual):
+    '''graph already built by the simulator (GraphObservation), same result as Graph_data_construction'''
+    mask_actual = torch.tensor(mask_actual).view(1, 4)
+    node_features = torch.tensor(node_features, dtype=torch.float).view(-1, dim_node_feature)
+    edge_features = torch.tensor(edge_features, dtype=torch.float).view(-1, dim_edge_feature)
+    state = Data(x=node_features, edge_index=edge_index, edge_attr=edge_features)
+    return (state, mask_actual)
+
+
 
@@ -0,0 +1,162 @@
+# * -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+# *
+# * Copyright (c) 2023 UCAS China
+# *
+# * This program is free software; you can redistribute it and/or modify
+# * it under the terms of the GNU General Public License version 2 as
+# * published by the Free Software Foundation;
+# *
+# * This program is distributed in the hope that it will be useful,
+# * but WITHOUT ANY WARRANTY; without even the implied warranty of
+# * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# * GNU General Public License for more details.
+# *
+# * You should have received a copy of the GNU General Public License
+# * along with this program; if not, write to the Free Software
+# * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+# *
+# * Author: HaiLong Su
+# *
+'''
+Launch several independent simulator instances and step them from one learner.
+
+Instance i of a launch gets
+  - gym port      base_port + i
+  - seed          base_seed + i (simSeed of ns3-gym and simulation_seed of basic-sim)
+  - run directory <work_dir>/run_<i>, a copy of the template run directory with
+                  rl_instance_id=i (and rl_experience_ring_name suffixed with _<i> if set)
+Every simulator writes logs_ns3/rl_decision_throughput.csv in its run directory,
+see model/decision-throughput-reporter.h.
+'''
+import argparse
+import os
+import shutil
+from concurrent.futures import ThreadPoolExecutor
+from ns3gym import ns3env
+
+THROUGHPUT_FILE = os.path.join('logs_ns3', 'rl_decision_throughput.csv')
+
+
+def instance_port(base_port, instance):
+    return base_port + instance
+
+
+def instance_seed(base_seed, instance):
+    return base_seed + instance
+
+
+def prepare_run_dir(template_run_dir, work_dir, instance, seed):
+    '''copy the template run directory and override the per-instance properties'''
+    run_dir = os.path.abspath(os.path.join(work_dir, "run_{0}".format(instance)))
+    if os.path.exists(run_dir):
+        shutil.rmtree(run_dir)
+    shutil.copytree(template_run_dir, run_dir, ignore=shutil.ignore_patterns('logs_ns3'))
+    overrides = {'simulation_seed': str(seed), 'rl_instance_id': str(instance)}
+    properties = os.path.join(run_dir, 'config_ns3.properties')
+    lines = list()
+    with open(properties) as f:
+        for line in f:
+            key = line.split('=')[0].strip()
+            if key == 'rl_experience_ring_name':
+                name = line.split('=', 1)[1].strip().strip('"')
+                overrides[key] = "\"{0}_{1}\"".format(name, instance)
+            if key not in overrides:
+                lines.append(line.rstrip('\n'))
+    for key, value in overrides.items():
+        lines.append("{0}={1}".format(key, value))
+    with open(properties, 'w') as f:
+        f.write('\n'.join(lines) + '\n')
+    os.makedirs(os.path.join(run_dir, 'logs_ns3'), exist_ok=True)
+    return run_dir
+
+
+def read_throughput(run_dir):
+    '''last line of the throughput report: (sim time ns, wall s, decisions, queries, decisions/s, queries/s)'''
+    path = os.path.join(run_dir, THROUGHPUT_FILE)
+    if not os.path.exists(path):
+        return None
+    last = None
+    with open(path) as f:
+        for line in f:
+            if line.strip() and not line.startswith('instance_id'):
+                last = line
+    if last is None:
+        return None
+    fields = last.strip().split(',')
+    return (int(fields[1]), float(fields[2]), int(fields[3]), int(fields[4]), float(fields[5]), float(fields[6]))
+
+
+class VectorEnv(object):
+    '''N simulators stepped together, each step() is sent to all of them concurrently'''
+    def __init__(self, num_instances, template_run_dir, work_dir, base_port=5555, base_seed=1, startSim=True):
+        self.num_instances = num_instances
+        self.run_dirs = list()
+        self.envs = list()
+        for i in range(num_instances):
+            seed = instance_seed(base_seed, i)
+            run_dir = prepare_run_dir(template_run_dir, work_dir, i, seed)
+            self.run_dirs.append(run_dir)
+            self.envs.append(ns3env.Ns3Env(port=instance_port(base_port, i), startSim=startSim,
+                                           simSeed=seed, simArgs={"--run_dir": run_dir}))
+        self.executor = ThreadPoolExecutor(max_workers=num_instances)
+        self.done = [False] * num_instances
+
+    def reset(self):
+        return list(self.executor.map(lambda env: env.reset(), self.envs))
+
+    def step(self, actions):
+        '''actions[i] goes to instance i; finished instances return (None, 0.0, True, None)'''
+        def step_one(i):
+            if self.done[i]:
+                return None, 0.0, True, None
+            obs, reward, done, info = self.envs[i].step(actions[i])
+            self.done[i] = done
+            return obs, reward, done, info
+        results = list(self.executor.map(step_one, range(self.num_instances)))
+        return [list(column) for column in zip(*results)]
+
+    def action_space_sample(self):
+        return [env.action_space.sample() for env in self.envs]
+
+    def all_done(self):
+        return all(self.done)
+
+    def throughput(self):
+        return [read_throughput(run_dir) for run_dir in self.run_dirs]
+
+    def close(self):
+        for env in self.envs:
+            env.close()
+        self.executor.shutdown()
+
+
+def get_config():
+    parser = argparse.ArgumentParser(description='Launch parallel simulator instances')
+    parser.add_argument("--num_instances", type=int, default=4, help="Number of simulators, default: 4")
+    parser.add_argument("--template_run_dir", type=str, required=True, help="Run directory copied for each instance")
+    parser.add_argument("--work_dir", type=str, default="./instances", help="Where run_<i> directories are created")
+    parser.add_argument("--base_port", type=int, default=5555, help="Gym port of instance 0, default: 5555")
+    parser.add_argument("--base_seed", type=int, default=1, help="Seed of instance 0, default: 1")
+    return parser.parse_args()
+
+
+if __name__ == '__main__':
+    args = get_config()
+    vector_env = VectorEnv(args.num_instances, args.template_run_dir, args.work_dir, args.base_port, args.base_seed)
+    vector_env.reset()
+    actions = vector_env.action_space_sample()
+    steps = 0
+    while not vector_env.all_done():
+        obs, rewards, dones, infos = vector_env.step(actions)
+        actions = vector_env.action_space_sample()
+        for i in range(args.num_instances):
+            # answer each agent with a random probability vector, keeping the requesting agent id
+            if obs[i] is not None:
+                actions[i]['AgentID'][0] = obs[i][0][0]
+        steps += 1
+        if steps % 10000 == 0:
+            for i, report in enumerate(vector_env.throughput()):
+                if report is not None:
+                    print("instance {0} | sim time {1:.1f}s | {2:.0f} decisions/s | {3:.0f} queries/s".format(
+                        i, report[0] / 1e9, report[4], report[5]))
+    vector_env.close()
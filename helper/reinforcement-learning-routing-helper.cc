@@ -25,21 +25,202 @@ namespace ns3 {
     void
     ReinforcementLearningRoutingHelper::InstallReinforcementLearningRouter (Ptr<BasicSimulation> basicSimulation, Ptr<TopologySatellite> satTopology, Ptr<MultiAgentGymEnvRouting> openGymEnv){
 		std::cout << "Set up reinforcement learning routing protocol." << std::endl;
-        satTopology->CalculateStaticRoute();
+        //!< Worker threads for node-local periodic work (1 keeps everything on the simulator thread)
+        ConstellationTickScheduler::Get()->SetNumThreads(
+                parse_positive_int64(basicSimulation->GetConfigParamOrDefault("tick_scheduler_num_threads", "1")));
+        //!< Optional shared memory ring streaming every policy query to an external learner
+        Ptr<ExperienceRingBuffer> experienceRing = nullptr;
+        std::string ringName = remove_start_end_double_quote_if_present(
+                basicSimulation->GetConfigParamOrDefault("rl_experience_ring_name", ""));
+        if (!ringName.empty()) {
+            //!< POSIX names start with the only slash, the segment is then /dev/shm<name>
+            if (ringName.at(0) != '/') {
+                ringName = "/" + ringName;
+            }
+            experienceRing = CreateObject<ExperienceRingBuffer>();
+            experienceRing->Open(ringName,
+                                 parse_positive_int64(basicSimulation->GetConfigParamOrDefault("rl_experience_ring_capacity", "65536")),
+                                 5 * FEATURE_SIZE);
+            std::cout << "  > Experience ring at /dev/shm" << ringName << std::endl;
+        }
+        //!< Asynchronous policy queries: forward with a fallback, query the agent in a separate event
+        bool asyncPolicyQuery = parse_boolean(basicSimulation->GetConfigParamOrDefault("rl_async_policy_query", "false"));
+        Time asyncQueryDelay = NanoSeconds(
+                parse_positive_int64(basicSimulation->GetConfigParamOrDefault("rl_async_query_delay_ns", "1000")));
+        std::string asyncFallback = basicSimulation->GetConfigParamOrDefault("rl_async_fallback", "stale");
+        //!< Staggered lifetime of dynamic routes and refresh of the ones in use ahead of expiry, 0 disables
+        double routeTtlJitter = parse_positive_double(basicSimulation->GetConfigParamOrDefault("rl_route_ttl_jitter", "0.0"));
+        Time routePrefetchLead = NanoSeconds(
+                parse_positive_int64(basicSimulation->GetConfigParamOrDefault("rl_route_prefetch_lead_ns", "0")));
+        //!< Optional 1 in N sampled hop by hop paths, 0 disables
+        Ptr<PathTracer> pathTracer = nullptr;
+        uint32_t pathTraceOneIn = parse_positive_int64(basicSimulation->GetConfigParamOrDefault("path_trace_sample_one_in", "0"));
+        if (pathTraceOneIn > 0) {
+            pathTracer = CreateObject<PathTracer>(pathTraceOneIn,
+                    parse_positive_int64(basicSimulation->GetConfigParamOrDefault("path_trace_ring_size", "4096")),
+                    parse_positive_int64(basicSimulation->GetConfigParamOrDefault("path_trace_max_flows", "1024")),
+                    basicSimulation->GetLogsDir() + "/path_trace.bin");
+        }
+        //!< Decision throughput of this instance, read by the launcher of parallel instances
+        uint32_t instanceId = parse_positive_int64(basicSimulation->GetConfigParamOrDefault("rl_instance_id", "0"));
+        Ptr<DecisionThroughputReporter> throughputReporter = CreateObject<DecisionThroughputReporter>(
+                basicSimulation->GetLogsDir() + "/rl_decision_throughput.csv", instanceId,
+                NanoSeconds(parse_positive_int64(basicSimulation->GetConfigParamOrDefault("rl_throughput_report_interval_ns", "1000000000"))));
+        //!< Optional flowlet cache of next hops, 0 disables
+        Time flowletGap = NanoSeconds(parse_positive_int64(basicSimulation->GetConfigParamOrDefault("rl_flowlet_gap_ns", "0")));
+        //!< Change-triggered link-state dissemination, the fixed half gather period if disabled
+        bool adaptiveLinkState = parse_boolean(basicSimulation->GetConfigParamOrDefault("enable_adaptive_link_state", "false"));
+        Time linkStateCheckPeriod = NanoSeconds(parse_positive_int64(basicSimulation->GetConfigParamOrDefault("link_state_check_period_ns", "100000000")));
+        Time linkStateMaxSilence = NanoSeconds(parse_positive_int64(basicSimulation->GetConfigParamOrDefault("link_state_max_silence_ns", "5000000000")));
+        double idleRatioThreshold = parse_positive_double(basicSimulation->GetConfigParamOrDefault("link_state_idle_ratio_threshold", "0.1"));
+        double dataRateThreshold = parse_positive_double(basicSimulation->GetConfigParamOrDefault("link_state_data_rate_threshold", "0.1"));
+        if (adaptiveLinkState && (!linkStateCheckPeriod.IsStrictlyPositive() || linkStateMaxSilence < linkStateCheckPeriod)) {
+            throw std::runtime_error("Adaptive link state needs 0 < link_state_check_period_ns <= link_state_max_silence_ns");
+        }
+        //!< One next-hop table shared by all satellites, filled once every arbiter knows its neighbors
+        Ptr<ShortestPathTable> shortestPaths = CreateObject<ShortestPathTable>(satTopology->GetNumSatellites());
+        //!< Shells of the constellation as "orbits x satellites per orbit" in node id order, one shell of the topology if empty
+        if (satTopology->GetObject<ConstellationIndex>() == nullptr) {
+            std::string shells = basicSimulation->GetConfigParamOrDefault("shells", "");
+            Ptr<ConstellationIndex> constellation = CreateObject<ConstellationIndex>(shells.empty()
+                    ? std::vector<std::pair<uint32_t, uint32_t>>{{(uint32_t) satTopology->GetNumOrbits(), (uint32_t) satTopology->GetNumSatellitesPerOrbit()}}
+                    : ConstellationIndex::ParseShells(shells));
+            if (constellation->GetNumSatellites() != satTopology->GetNumSatellites()) {
+                throw std::runtime_error(format_string(
+                        "The shells hold %d satellites but the topology has %d.",
+                        constellation->GetNumSatellites(), satTopology->GetNumSatellites()
+                ));
+            }
+            for (int i = 0; i < satTopology->GetNumUndirectedEdges(); i++) {
+                std::pair<int64_t, int64_t> edge = satTopology->GetUndirectedEdges().at(i);
+                if (constellation->GetShell(edge.first) != constellation->GetShell(edge.second)) {
+                    constellation->AddCrossShellLink(edge.first, edge.second);
+                }
+            }
+            std::cout << "  > Constellation of " << constellation->GetNumShells() << " shell(s)" << std::endl;
+            satTopology->AggregateObject(constellation);
+        }
+        //!< Serving satellite of every terminal, pushed on handover and read by the arbiters through the topology.
+        //!< Nothing pushes handovers yet, so entries read from the topology are not cached unless a TTL is set.
+        if (satTopology->GetObject<TerminalAttachmentTable>() == nullptr) {
+            satTopology->AggregateObject(CreateObject<TerminalAttachmentTable>(satTopology, satTopology->GetNodes(),
+                    NanoSeconds(parse_positive_int64(basicSimulation->GetConfigParamOrDefault("terminal_attachment_ttl_ns", "0")))));
+        }
+        std::vector<Ptr<ReinforcementSingleForward>> agents;
 		for (uint32_t agentId = 0; agentId < satTopology->GetNumSatellites(); agentId++) {
-            std::vector<std::vector<uint32_t>> static_routing_table = satTopology->GetGlobalRoutingList()[agentId];
-			Ptr<ReinforcementSingleForward> reinforceSingleForward = CreateObject<ReinforcementSingleForward>(satTopology->GetSatelliteNodes().Get(agentId), satTopology->GetNodes(), satTopology, openGymEnv,static_routing_table);
+			Ptr<ReinforcementSingleForward> reinforceSingleForward = CreateObject<ReinforcementSingleForward>(satTopology->GetSatelliteNodes().Get(agentId), satTopology->GetNodes(), satTopology, openGymEnv, shortestPaths);
+            //!< Cross-shell ISLs take the slots after the four directions, so failures and routes across shells are known
+            shortestPaths->SetNeighbors(agentId, reinforceSingleForward->GetLinkNeighbors());
             satTopology->GetSatelliteNodes().Get(agentId)->GetObject<Ipv4>()->GetRoutingProtocol()->GetObject<Ipv4ArbiterRouting>()->SetArbiter(reinforceSingleForward);
+            if (experienceRing != nullptr) {
+                reinforceSingleForward->SetExperienceRing(experienceRing);
+            }
+            if (pathTracer != nullptr) {
+                reinforceSingleForward->SetPathTracer(pathTracer);
+            }
+            reinforceSingleForward->SetAsyncPolicyQuery(asyncPolicyQuery, asyncQueryDelay, asyncFallback);
+            reinforceSingleForward->SetDynamicRouteRefresh(routeTtlJitter, routePrefetchLead);
+            throughputReporter->AddArbiter(reinforceSingleForward);
+            agents.push_back(reinforceSingleForward);
+            reinforceSingleForward->SetFlowletGap(flowletGap);
+            if (adaptiveLinkState) {
+                reinforceSingleForward->SetAdaptiveLinkStateBroadcast(linkStateCheckPeriod, idleRatioThreshold, dataRateThreshold, linkStateMaxSilence);
+            }
 
             Ptr<ServiceLinkManager> serviceLinkManager = CreateObject<ServiceLinkManager> (satTopology->GetCapacity(),agentId);
             satTopology->GetSatelliteNodes().Get(agentId)->GetObject<Ipv4>()->GetRoutingProtocol()
                     ->GetObject<Ipv4ArbiterRouting>()->GetArbiter()->GetObject<ReinforcementLearningArbiter>()->SetServiceManager(serviceLinkManager);
 		}
+        //!< 0 uses every hardware thread
+        uint32_t shortestPathThreads = parse_positive_int64(basicSimulation->GetConfigParamOrDefault("shortest_path_num_threads", "0"));
+        if (shortestPathThreads == 0) {
+            shortestPathThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        std::cout << "Calculate shortest paths." << std::endl;
+        shortestPaths->Compute(shortestPathThreads);
+        for (uint32_t k = 0; k < shortestPaths->GetThreadSeconds().size(); k++) {
+            std::cout << "  > Thread " << k << ": " << shortestPaths->GetThreadTargets().at(k) << " targets in "
+                      << shortestPaths->GetThreadSeconds().at(k) << " s" << std::endl;
+        }
+        basicSimulation->RegisterTimestamp("Calculate shortest paths");
+        //!< Optional sub-satellite point grid for terminal association and handover, found through the topology.
+        //!< Off by default: it propagates the constellation every refresh and the handover code using it is outside this module.
+        if (parse_boolean(basicSimulation->GetConfigParamOrDefault("enable_spatial_index", "false")) &&
+                satTopology->GetObject<SatelliteSpatialIndex>() == nullptr) {
+            Ptr<SatelliteSpatialIndex> spatialIndex = CreateObject<SatelliteSpatialIndex>(satTopology,
+                    parse_positive_double(basicSimulation->GetConfigParamOrDefault("spatial_index_cell_degrees", "5.0")),
+                    parse_positive_double(basicSimulation->GetConfigParamOrDefault("minimum_elevation_handover_degree", "25.0")));
+            spatialIndex->Start(NanoSeconds(parse_positive_int64(
+                    basicSimulation->GetConfigParamOrDefault("spatial_index_refresh_period_ns", "1000000000"))));
+            satTopology->AggregateObject(spatialIndex);
+        }
+        //!< Optional background UDP bursts modeled as fluid rates, the packet schedule keeps the probe flows
+        std::string fluidSchedule = remove_start_end_double_quote_if_present(
+                basicSimulation->GetConfigParamOrDefault("fluid_udp_burst_schedule_filename", ""));
+        if (!fluidSchedule.empty()) {
+            Ptr<FluidTrafficModel> fluidTraffic = CreateObject<FluidTrafficModel>(satTopology, shortestPaths,
+                    parse_positive_double(basicSimulation->GetConfigParamOrDefault("isl_data_rate_megabit_per_s_intra", "100")) * 1e6,
+                    parse_positive_double(basicSimulation->GetConfigParamOrDefault("isl_data_rate_megabit_per_s_inter", "100")) * 1e6,
+                    parse_positive_int64(basicSimulation->GetConfigParamOrDefault("isl_max_queue_size_pkts", "100")),
+                    parse_positive_int64(basicSimulation->GetConfigParamOrDefault("fluid_packet_size_byte", "1500")));
+            fluidTraffic->ReadSchedule(basicSimulation->GetRunDir() + "/" + fluidSchedule);
+            fluidTraffic->Start(NanoSeconds(parse_positive_int64(
+                    basicSimulation->GetConfigParamOrDefault("fluid_step_ns", "10000000"))));
+            satTopology->AggregateObject(fluidTraffic);
+            std::cout << "  > " << fluidTraffic->GetNumFlows() << " fluid flows" << std::endl;
+        }
+        //!< Optional ISL distances and delays sampled once per step for all links, 0 reads the mobility models directly.
+        //!< Interpolated samples and the relative speed over a step differ from the live reads trained models saw.
+        int64_t linkGeometryStepNs = parse_positive_int64(basicSimulation->GetConfigParamOrDefault("link_geometry_step_ns", "0"));
+        if (linkGeometryStepNs > 0) {
+            Ptr<LinkGeometryTable> linkGeometry = CreateObject<LinkGeometryTable>(satTopology, NanoSeconds(linkGeometryStepNs));
+            linkGeometry->Start();
+            satTopology->AggregateObject(linkGeometry);
+        }
         std::cout << "Record Interfaces." << std::endl;
         for (uint32_t agentId = 0; agentId < satTopology->GetNumSatellites(); agentId++) {
             satTopology->GetSatelliteNodes().Get(agentId)->GetObject<Ipv4>()->GetRoutingProtocol()
             ->GetObject<Ipv4ArbiterRouting>()->GetArbiter()->GetObject<ReinforcementSingleForward>()->RecordInterfaces();
         }
+        throughputReporter->Start();
+        if (parse_boolean(basicSimulation->GetConfigParamOrDefault("enable_memory_report", "true"))) {
+            Simulator::ScheduleDestroy(&ReinforcementLearningRoutingHelper::WriteMemoryReport, basicSimulation, agents);
+        }
+        //!< Optional delay and jitter histograms of every flow between user terminals, written at the end of the run
+        if (parse_boolean(basicSimulation->GetConfigParamOrDefault("enable_flow_latency_histograms", "false"))) {
+            NodeContainer terminals;
+            for (uint32_t nodeId = 0; nodeId < satTopology->GetNodes().GetN(); nodeId++) {
+                if (satTopology->IsUserTerminalId(nodeId)) {
+                    terminals.Add(satTopology->GetNodes().Get(nodeId));
+                }
+            }
+            CreateObject<FlowLatencyTracker>(terminals,
+                                             basicSimulation->GetLogsDir() + "/flow_latency_percentiles.csv",
+                                             basicSimulation->GetLogsDir() + "/flow_latency_histograms.csv");
+        }
+        //!< Optional ISL utilization over time, one binary file of directed ISL x time bin counters
+        if (parse_boolean(basicSimulation->GetConfigParamOrDefault("enable_isl_utilization_bins", "false"))) {
+            int64_t binWidthNs = parse_positive_int64(basicSimulation->GetConfigParamOrDefault("isl_utilization_bin_ns", "100000000"));
+            if (binWidthNs < 10000000 || binWidthNs > 1000000000) {
+                throw std::runtime_error(format_string(
+                        "ISL utilization bin width %lld ns is outside of [10 ms, 1 s].", (long long) binWidthNs
+                ));
+            }
+            CreateObject<IslUtilizationRecorder>(satTopology, NanoSeconds(binWidthNs),
+                                                 NanoSeconds(basicSimulation->GetSimulationEndTimeNs()),
+                                                 basicSimulation->GetLogsDir() + "/isl_utilization_bins.bin");
+        }
         basicSimulation->RegisterTimestamp("Set up reinforcement learning routing protocol.");
 	}
+
+    void
+    ReinforcementLearningRoutingHelper::WriteMemoryReport (Ptr<BasicSimulation> basicSimulation, std::vector<Ptr<ReinforcementSingleForward>> agents)
+    {
+        std::vector<const MemoryAccount *> owners;
+        for (const Ptr<ReinforcementSingleForward> &agent : agents) {
+            owners.push_back(&agent->GetMemoryAccount());
+        }
+        MemoryAccounting::WriteReport(basicSimulation->GetRunDir() + "/memory_usage.txt",
+                                      basicSimulation->GetRunDir() + "/memory_usage_per_satellite.csv", owners);
+    }
 }
\ No newline at end of file
@@ -28,6 +28,16 @@
 #include "ns3/reinforcement-learning-arbiter.h"
 #include "ns3/reinforcement-learning-single-forward.h"
 #include "ns3/multi-agent-env.h"
+#include "ns3/constellation-tick-scheduler.h"
+#include "ns3/decision-throughput-reporter.h"
+#include "ns3/shortest-path-table.h"
+#include "ns3/satellite-spatial-index.h"
+#include "ns3/terminal-attachment-table.h"
+#include "ns3/flow-latency-tracker.h"
+#include "ns3/isl-utilization-recorder.h"
+#include "ns3/constellation-index.h"
+#include "ns3/link-geometry-table.h"
+#include <thread>
 
 namespace ns3 {
    
@@ -35,6 +45,9 @@ namespace ns3 {
     {
      public:
           static void InstallReinforcementLearningRouter (Ptr<BasicSimulation> basicSimulation, Ptr<TopologySatellite> satTopology,Ptr<MultiAgentGymEnvRouting> openGymEnv);
+          //!< Memory per category and per satellite, written to the run directory when the simulator is destroyed.
+          //!< The agents are held directly, the nodes and their routing protocols are disposed by then.
+          static void WriteMemoryReport (Ptr<BasicSimulation> basicSimulation, std::vector<Ptr<ReinforcementSingleForward>> agents);
     };
     
 
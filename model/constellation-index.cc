@@ -0,0 +1,167 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "constellation-index.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace ns3 {
+
+    NS_LOG_COMPONENT_DEFINE ("ConstellationIndex");
+    NS_OBJECT_ENSURE_REGISTERED (ConstellationIndex);
+
+    TypeId
+    ConstellationIndex::GetTypeId (void)
+    {
+        static TypeId tid = TypeId ("ns3::ConstellationIndex")
+                .SetParent<Object> ()
+                .SetGroupName("RoutingRL")
+        ;
+        return tid;
+    }
+
+    ConstellationIndex::ConstellationIndex (const std::vector<std::pair<uint32_t, uint32_t>> &shells)
+    {
+        if (shells.empty() || shells.size() > std::numeric_limits<uint16_t>::max()) {
+            throw std::runtime_error("A constellation needs between 1 and 65535 shells");
+        }
+        uint32_t firstNode = 0;
+        for (const std::pair<uint32_t, uint32_t> &shell : shells) {
+            if (shell.first == 0 || shell.second == 0 ||
+                shell.first > std::numeric_limits<uint16_t>::max() || shell.second > std::numeric_limits<uint16_t>::max()) {
+                throw std::runtime_error("Invalid shell of " + std::to_string(shell.first) + " orbits of "
+                                         + std::to_string(shell.second) + " satellites");
+            }
+            m_shells.push_back(Shell{firstNode, shell.first, shell.second});
+            for (uint32_t i = 0; i < shell.first * shell.second; i++) {
+                m_shell.push_back((uint16_t) (m_shells.size() - 1));
+                m_orbit.push_back((uint16_t) (i / shell.second));
+                m_phase.push_back((uint16_t) (i % shell.second));
+            }
+            firstNode += shell.first * shell.second;
+        }
+        m_crossShellLinks = std::vector<std::vector<std::pair<uint32_t, uint32_t>>>(m_shells.size() * m_shells.size());
+    }
+
+    ConstellationIndex::~ConstellationIndex ()
+    {
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>>
+    ConstellationIndex::ParseShells (const std::string &shells)
+    {
+        std::vector<std::pair<uint32_t, uint32_t>> result;
+        std::istringstream in(shells);
+        std::string item;
+        while (std::getline(in, item, ',')) {
+            size_t x = item.find('x');
+            if (x == std::string::npos) {
+                throw std::runtime_error("Shell \"" + item + "\" is not of the form orbits x satellites per orbit");
+            }
+            result.push_back({(uint32_t) std::stoul(item.substr(0, x)), (uint32_t) std::stoul(item.substr(x + 1))});
+        }
+        return result;
+    }
+
+    void
+    ConstellationIndex::AddCrossShellLink (uint32_t a, uint32_t b)
+    {
+        uint32_t shellA = m_shell.at(a);
+        uint32_t shellB = m_shell.at(b);
+        if (shellA == shellB) {
+            throw std::runtime_error("Satellites " + std::to_string(a) + " and " + std::to_string(b) + " are in the same shell");
+        }
+        m_crossShellLinks[shellA * m_shells.size() + shellB].push_back({a, b});
+        m_crossShellLinks[shellB * m_shells.size() + shellA].push_back({b, a});
+    }
+
+    uint32_t
+    ConstellationIndex::GetNumShells () const
+    {
+        return m_shells.size();
+    }
+
+    uint32_t
+    ConstellationIndex::GetNumSatellites () const
+    {
+        return m_shell.size();
+    }
+
+    const ConstellationIndex::Shell &
+    ConstellationIndex::GetShellInfo (uint32_t shell) const
+    {
+        return m_shells.at(shell);
+    }
+
+    int32_t
+    ConstellationIndex::GetDirection (uint32_t from, uint32_t to) const
+    {
+        if (m_shell[from] != m_shell[to]) {
+            return NOT_ADJACENT;
+        }
+        const Shell &shell = m_shells[m_shell[from]];
+        if (m_orbit[from] == m_orbit[to]) {
+            if (m_phase[to] == (m_phase[from] + 1) % shell.numSatellitesPerOrbit) {
+                return 0;
+            }
+            if (m_phase[from] == (m_phase[to] + 1) % shell.numSatellitesPerOrbit) {
+                return 1;
+            }
+            return NOT_ADJACENT;
+        }
+        //!< Any satellite of an adjacent orbit, as the ISLs may be phase shifted
+        if (m_orbit[to] == (m_orbit[from] + 1) % shell.numOrbits) {
+            return 3;
+        }
+        if (m_orbit[from] == (m_orbit[to] + 1) % shell.numOrbits) {
+            return 2;
+        }
+        return NOT_ADJACENT;
+    }
+
+    uint32_t
+    ConstellationIndex::GetGridDistance (uint32_t a, uint32_t b) const
+    {
+        const Shell &shell = m_shells[m_shell[a]];
+        uint32_t orbits = std::abs((int32_t) m_orbit[a] - (int32_t) m_orbit[b]);
+        uint32_t phases = std::abs((int32_t) m_phase[a] - (int32_t) m_phase[b]);
+        return std::min(orbits, shell.numOrbits - orbits) + std::min(phases, shell.numSatellitesPerOrbit - phases);
+    }
+
+    uint32_t
+    ConstellationIndex::GetHopDistance (uint32_t a, uint32_t b) const
+    {
+        if (m_shell[a] == m_shell[b]) {
+            return GetGridDistance(a, b);
+        }
+        uint32_t best = UNREACHABLE;
+        for (const std::pair<uint32_t, uint32_t> &link : m_crossShellLinks[m_shell[a] * m_shells.size() + m_shell[b]]) {
+            best = std::min(best, GetGridDistance(a, link.first) + 1 + GetGridDistance(link.second, b));
+        }
+        return best;
+    }
+
+}
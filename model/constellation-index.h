@@ -0,0 +1,115 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#ifndef SATELLITE_NETWORK_CONSTELLATION_INDEX_H
+#define SATELLITE_NETWORK_CONSTELLATION_INDEX_H
+
+#include "ns3/object.h"
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * Position of every satellite in a constellation of one or more shells, each shell a grid of
+     * orbits x satellites per orbit wrapping around as a torus, with optional links between shells.
+     *
+     * Satellites are numbered shell by shell, orbit by orbit, as in the TLE file. Shell, orbit and
+     * phase of a node are stored per node and the first node of each shell per shell, so the grid
+     * direction between two satellites and their hop distance within a shell are O(1).
+     */
+    class ConstellationIndex : public Object
+    {
+    public:
+        static TypeId GetTypeId (void);
+
+        //!< Direction of a satellite that is not a grid neighbor, or is in another shell
+        static const int32_t NOT_ADJACENT = -1;
+        static const uint32_t UNREACHABLE = 0xFFFFFFFF;
+
+        struct Shell {
+            uint32_t firstNode;
+            uint32_t numOrbits;
+            uint32_t numSatellitesPerOrbit;
+        };
+
+        /**
+         * @param shells  (orbits, satellites per orbit) of every shell, in node id order
+         */
+        ConstellationIndex (const std::vector<std::pair<uint32_t, uint32_t>> &shells);
+        ~ConstellationIndex ();
+
+        /**
+         * Parse shells written as "orbits x satellites per orbit" separated by commas, e.g. "72x22,36x20".
+         */
+        static std::vector<std::pair<uint32_t, uint32_t>> ParseShells (const std::string &shells);
+
+        /**
+         * Declare an ISL between two satellites of different shells.
+         */
+        void AddCrossShellLink (uint32_t a, uint32_t b);
+
+        uint32_t GetNumShells () const;
+        uint32_t GetNumSatellites () const;
+        const Shell &GetShellInfo (uint32_t shell) const;
+
+        uint32_t GetShell (uint32_t node) const
+        {
+            return m_shell[node];
+        }
+
+        uint32_t GetOrbit (uint32_t node) const
+        {
+            return m_orbit[node];
+        }
+
+        uint32_t GetPhase (uint32_t node) const
+        {
+            return m_phase[node];
+        }
+
+        /**
+         * @return direction of to as seen from from: 0 north (next in orbit), 1 south (previous in orbit),
+         *         2 west (previous orbit), 3 east (next orbit), NOT_ADJACENT otherwise
+         */
+        int32_t GetDirection (uint32_t from, uint32_t to) const;
+
+        /**
+         * Geometric estimate that ignores failed links: O(1) within a shell, across shells a scan of
+         * the cross-shell links between the two shells. Per-packet decisions read ShortestPathTable.
+         * @return hops on the grid within a shell, across shells through the best single cross-shell
+         *         link between them, UNREACHABLE if there is none
+         */
+        uint32_t GetHopDistance (uint32_t a, uint32_t b) const;
+
+    private:
+        uint32_t GetGridDistance (uint32_t a, uint32_t b) const;
+        std::vector<Shell> m_shells;
+        std::vector<uint16_t> m_shell;
+        std::vector<uint16_t> m_orbit;
+        std::vector<uint16_t> m_phase;
+        std::vector<std::vector<std::pair<uint32_t, uint32_t>>> m_crossShellLinks;   //!< [shell a * shells + shell b], (node in a, node in b)
+    };
+
+}
+
+#endif //SATELLITE_NETWORK_CONSTELLATION_INDEX_H
@@ -0,0 +1,158 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "constellation-tick-scheduler.h"
+#include "parallel-for.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+    NS_LOG_COMPONENT_DEFINE ("ConstellationTickScheduler");
+    NS_OBJECT_ENSURE_REGISTERED (ConstellationTickScheduler);
+
+    Ptr<ConstellationTickScheduler> ConstellationTickScheduler::s_scheduler = nullptr;
+
+    TypeId
+    ConstellationTickScheduler::GetTypeId (void)
+    {
+        static TypeId tid = TypeId ("ns3::ConstellationTickScheduler")
+                .SetParent<Object> ()
+                .SetGroupName("RoutingRL")
+        ;
+        return tid;
+    }
+
+    Ptr<ConstellationTickScheduler>
+    ConstellationTickScheduler::Get (void)
+    {
+        if (s_scheduler == nullptr) {
+            s_scheduler = CreateObject<ConstellationTickScheduler>();
+            Simulator::ScheduleDestroy(&ConstellationTickScheduler::Release);
+        }
+        return s_scheduler;
+    }
+
+    void
+    ConstellationTickScheduler::Release (void)
+    {
+        if (s_scheduler != nullptr) {
+            s_scheduler->Dispose();
+            s_scheduler = nullptr;
+        }
+    }
+
+    ConstellationTickScheduler::ConstellationTickScheduler ()
+    {
+        m_numThreads = 1;
+    }
+
+    ConstellationTickScheduler::~ConstellationTickScheduler ()
+    {
+        // Left empty intentionally
+    }
+
+    void
+    ConstellationTickScheduler::DoDispose (void)
+    {
+        //!< Members are bound to raw pointers of objects disposed with the simulation
+        m_classes.clear();
+        Object::DoDispose();
+    }
+
+    uint32_t
+    ConstellationTickScheduler::GetTaskClass (std::string name, Time start, Time period)
+    {
+        for (uint32_t i = 0; i < m_classes.size(); ++i) {
+            if (m_classes[i].name == name) {
+                if (m_classes[i].period != period) {
+                    throw std::runtime_error("Task class " + name + " is already registered with another period.");
+                }
+                return i;
+            }
+        }
+        NS_ASSERT(period.IsStrictlyPositive());
+        TaskClass taskClass;
+        taskClass.name = name;
+        taskClass.period = period;
+        taskClass.ticks = 0;
+        m_classes.push_back(taskClass);
+        uint32_t id = m_classes.size() - 1;
+        Simulator::Schedule(start, &ConstellationTickScheduler::Tick, this, id);
+        return id;
+    }
+
+    void
+    ConstellationTickScheduler::Subscribe (uint32_t taskClass, Callback<void> commit)
+    {
+        Subscribe(taskClass, Callback<void>(), commit);
+    }
+
+    void
+    ConstellationTickScheduler::Subscribe (uint32_t taskClass, Callback<void> prepare, Callback<void> commit)
+    {
+        NS_ASSERT(taskClass < m_classes.size());
+        m_classes[taskClass].prepare.push_back(prepare);
+        m_classes[taskClass].commit.push_back(commit);
+    }
+
+    void
+    ConstellationTickScheduler::SetNumThreads (uint32_t numThreads)
+    {
+        NS_ASSERT(numThreads >= 1);
+        m_numThreads = numThreads;
+    }
+
+    uint32_t
+    ConstellationTickScheduler::GetNumThreads (void) const
+    {
+        return m_numThreads;
+    }
+
+    uint64_t
+    ConstellationTickScheduler::GetNumTicks (uint32_t taskClass) const
+    {
+        NS_ASSERT(taskClass < m_classes.size());
+        return m_classes[taskClass].ticks;
+    }
+
+    void
+    ConstellationTickScheduler::Tick (uint32_t taskClass)
+    {
+        NS_LOG_FUNCTION (this << m_classes[taskClass].name);
+        const std::vector<Callback<void>> &prepare = m_classes[taskClass].prepare;
+        uint32_t count = prepare.size();
+        ParallelFor(m_numThreads, count, [&prepare] (uint32_t i) {
+            if (!prepare[i].IsNull()) {
+                prepare[i]();
+            }
+        });
+        //!< Commit callbacks may register new classes or members, so index instead of holding references
+        for (uint32_t i = 0; i < count; ++i) {
+            Callback<void> commit = m_classes[taskClass].commit[i];
+            commit();
+        }
+        m_classes[taskClass].ticks++;
+        Simulator::Schedule(m_classes[taskClass].period, &ConstellationTickScheduler::Tick, this, taskClass);
+    }
+
+}
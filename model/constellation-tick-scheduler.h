@@ -0,0 +1,111 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#ifndef SATELLITE_NETWORK_CONSTELLATION_TICK_SCHEDULER_H
+#define SATELLITE_NETWORK_CONSTELLATION_TICK_SCHEDULER_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/callback.h"
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * Constellation-wide tick service for periodic per-satellite and per-ISL tasks.
+     *
+     * Every task class (e.g. link state broadcast) owns one simulator event per period
+     * instead of one per member. A tick first runs the prepare callbacks of all members,
+     * which must not have cross-node side effects and may run on worker threads, then
+     * the commit callbacks on the simulator thread in subscription order.
+     */
+    class ConstellationTickScheduler : public Object
+    {
+    public:
+        static TypeId GetTypeId (void);
+
+        /**
+         * \returns the scheduler shared by all satellites and ISLs, created on first use
+         * after each Simulator::Destroy
+         */
+        static Ptr<ConstellationTickScheduler> Get (void);
+
+        ConstellationTickScheduler ();
+        ~ConstellationTickScheduler ();
+
+        /**
+         * Find a task class by name, or create it with its first tick after start.
+         * @param name      name of the task class
+         * @param start     delay of the first tick from now
+         * @param period    interval between ticks
+         * @return id of the task class
+         */
+        uint32_t GetTaskClass (std::string name, Time start, Time period);
+
+        /**
+         * Add a member whose work runs on the simulator thread.
+         */
+        void Subscribe (uint32_t taskClass, Callback<void> commit);
+
+        /**
+         * Add a member with node-local work that may run in parallel, followed by serial work.
+         * @param prepare   node-local part, no cross-node side effects
+         * @param commit    part that may touch other nodes
+         */
+        void Subscribe (uint32_t taskClass, Callback<void> prepare, Callback<void> commit);
+
+        /**
+         * Set threads used for prepare callbacks, 1 runs them on the simulator thread.
+         */
+        void SetNumThreads (uint32_t numThreads);
+
+        uint32_t GetNumThreads (void) const;
+
+        /**
+         * \returns number of ticks a task class has run
+         */
+        uint64_t GetNumTicks (uint32_t taskClass) const;
+
+    protected:
+        virtual void DoDispose (void);
+
+    private:
+        void Tick (uint32_t taskClass);
+        //!< Scheduled at Simulator::Destroy, so that the next run starts without the task classes of this one
+        static void Release (void);
+        static Ptr<ConstellationTickScheduler> s_scheduler;
+
+        struct TaskClass {
+            std::string name;
+            Time period;
+            std::vector<Callback<void>> prepare;    //!< null callback when a member has no prepare part
+            std::vector<Callback<void>> commit;
+            uint64_t ticks;
+        };
+        std::vector<TaskClass> m_classes;
+        uint32_t m_numThreads;
+    };
+
+}
+
+#endif //SATELLITE_NETWORK_CONSTELLATION_TICK_SCHEDULER_H
@@ -0,0 +1,126 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "decision-throughput-reporter.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+    NS_LOG_COMPONENT_DEFINE ("DecisionThroughputReporter");
+    NS_OBJECT_ENSURE_REGISTERED (DecisionThroughputReporter);
+
+    TypeId
+    DecisionThroughputReporter::GetTypeId (void)
+    {
+        static TypeId tid = TypeId ("ns3::DecisionThroughputReporter")
+                .SetParent<Object> ()
+                .SetGroupName("RoutingRL")
+        ;
+        return tid;
+    }
+
+    DecisionThroughputReporter::DecisionThroughputReporter (std::string filename, uint32_t instanceId, Time interval)
+    {
+        NS_ASSERT(interval.IsStrictlyPositive());
+        m_file.open(filename, std::ofstream::out | std::ofstream::trunc);
+        if (!m_file.is_open()) {
+            throw std::runtime_error("Cannot open throughput report " + filename);
+        }
+        m_file << "instance_id,time_ns,wall_s,decisions,queries,decisions_per_s,queries_per_s,"
+               << "flowlet_hits,flowlet_misses,flowlet_hit_ratio,link_state_sent,link_state_suppressed,routes_prefetched" << std::endl;
+        m_instanceId = instanceId;
+        m_interval = interval;
+        m_lastDecisions = 0;
+        m_lastQueries = 0;
+        m_wallStart = std::chrono::steady_clock::now();
+        m_wallLast = m_wallStart;
+    }
+
+    DecisionThroughputReporter::~DecisionThroughputReporter ()
+    {
+    }
+
+    void
+    DecisionThroughputReporter::DoDispose (void)
+    {
+        Simulator::Cancel(m_event);
+        m_arbiters.clear();
+        if (m_file.is_open()) {
+            m_file.close();
+        }
+        Object::DoDispose();
+    }
+
+    void
+    DecisionThroughputReporter::AddArbiter (Ptr<ReinforcementSingleForward> arbiter)
+    {
+        m_arbiters.push_back(arbiter);
+    }
+
+    void
+    DecisionThroughputReporter::Start ()
+    {
+        m_wallStart = std::chrono::steady_clock::now();
+        m_wallLast = m_wallStart;
+        //!< The pending event holds a reference, so the reporter lives as long as the simulation
+        m_event = Simulator::Schedule(m_interval, &DecisionThroughputReporter::Report,
+                                      Ptr<DecisionThroughputReporter>(this));
+    }
+
+    void
+    DecisionThroughputReporter::Report ()
+    {
+        uint64_t decisions = 0;
+        uint64_t queries = 0;
+        uint64_t flowletHits = 0;
+        uint64_t flowletMisses = 0;
+        uint64_t linkStateSent = 0;
+        uint64_t linkStateSuppressed = 0;
+        uint64_t prefetchedRoutes = 0;
+        for (const Ptr<ReinforcementSingleForward> &arbiter : m_arbiters) {
+            decisions += arbiter->GetNumDecisions();
+            queries += arbiter->GetTimesUsingRL();
+            flowletHits += arbiter->GetFlowletHits();
+            flowletMisses += arbiter->GetFlowletMisses();
+            linkStateSent += arbiter->GetLinkStateUpdatesSent();
+            linkStateSuppressed += arbiter->GetLinkStateUpdatesSuppressed();
+            prefetchedRoutes += arbiter->GetNumPrefetchedRoutes();
+        }
+        double flowletHitRatio = flowletHits + flowletMisses > 0 ? (double) flowletHits / (flowletHits + flowletMisses) : 0.0;
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - m_wallStart).count();
+        double interval = std::chrono::duration<double>(now - m_wallLast).count();
+        double decisionRate = interval > 0 ? (double) (decisions - m_lastDecisions) / interval : 0.0;
+        double queryRate = interval > 0 ? (double) (queries - m_lastQueries) / interval : 0.0;
+        m_file << m_instanceId << "," << Simulator::Now().GetNanoSeconds() << "," << elapsed << ","
+               << decisions << "," << queries << "," << decisionRate << "," << queryRate << ","
+               << flowletHits << "," << flowletMisses << "," << flowletHitRatio << ","
+               << linkStateSent << "," << linkStateSuppressed << "," << prefetchedRoutes << std::endl;
+        m_wallLast = now;
+        m_lastDecisions = decisions;
+        m_lastQueries = queries;
+        m_event = Simulator::Schedule(m_interval, &DecisionThroughputReporter::Report,
+                                      Ptr<DecisionThroughputReporter>(this));
+    }
+
+}
@@ -0,0 +1,92 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#ifndef SATELLITE_NETWORK_DECISION_THROUGHPUT_REPORTER_H
+#define SATELLITE_NETWORK_DECISION_THROUGHPUT_REPORTER_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "reinforcement-learning-single-forward.h"
+#include <chrono>
+#include <fstream>
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * Periodic report of the routing decision throughput of one simulator instance.
+     *
+     * The CSV starts with a header row, then one line per interval with the columns:
+     *   instance_id                 id of this instance among those launched together
+     *   time_ns                     simulation time
+     *   wall_s                      wall clock since start
+     *   decisions, queries          routing decisions and policy queries so far
+     *   decisions_per_s, queries_per_s   per wall clock second over the last interval
+     *   flowlet_hits, flowlet_misses, flowlet_hit_ratio   flowlet cache so far
+     *   link_state_sent, link_state_suppressed   link-state updates so far
+     *   routes_prefetched           dynamic routes queried again ahead of expiry so far
+     * A launcher running several instances side by side reads one such file per run directory.
+     */
+    class DecisionThroughputReporter : public Object
+    {
+    public:
+        static TypeId GetTypeId (void);
+
+        /**
+         * @param filename  CSV file to write, truncated
+         * @param instanceId  id of this instance among those launched together
+         * @param interval  simulation time between two lines
+         */
+        DecisionThroughputReporter (std::string filename, uint32_t instanceId, Time interval);
+        ~DecisionThroughputReporter ();
+
+        void AddArbiter (Ptr<ReinforcementSingleForward> arbiter);
+
+        /**
+         * Schedule the first report one interval from now.
+         */
+        void Start ();
+
+        /**
+         * Write one line and schedule the next one.
+         */
+        void Report ();
+
+    protected:
+        virtual void DoDispose (void);
+
+    private:
+        std::vector<Ptr<ReinforcementSingleForward>> m_arbiters;
+        std::ofstream m_file;
+        uint32_t m_instanceId;
+        Time m_interval;
+        EventId m_event;
+        std::chrono::steady_clock::time_point m_wallStart;
+        std::chrono::steady_clock::time_point m_wallLast;
+        uint64_t m_lastDecisions;
+        uint64_t m_lastQueries;
+    };
+
+}
+
+#endif //SATELLITE_NETWORK_DECISION_THROUGHPUT_REPORTER_H
@@ -0,0 +1,179 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "experience-ring-buffer.h"
+#include "ns3/log.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdexcept>
+
+namespace ns3 {
+
+    NS_LOG_COMPONENT_DEFINE ("ExperienceRingBuffer");
+    NS_OBJECT_ENSURE_REGISTERED (ExperienceRingBuffer);
+
+    TypeId
+    ExperienceRingBuffer::GetTypeId (void)
+    {
+        static TypeId tid = TypeId ("ns3::ExperienceRingBuffer")
+                .SetParent<Object> ()
+                .SetGroupName("RoutingRL")
+        ;
+        return tid;
+    }
+
+    ExperienceRingBuffer::ExperienceRingBuffer ()
+    {
+        m_base = nullptr;
+        m_size = 0;
+        m_header = nullptr;
+        m_records = nullptr;
+        m_recordSize = 0;
+        m_capacity = 0;
+        m_stateDim = 0;
+        m_pushed = 0;
+        m_dropped = 0;
+    }
+
+    ExperienceRingBuffer::~ExperienceRingBuffer ()
+    {
+        Close();
+    }
+
+    void
+    ExperienceRingBuffer::DoDispose (void)
+    {
+        Close();
+        Object::DoDispose();
+    }
+
+    void
+    ExperienceRingBuffer::Open (std::string name, uint32_t capacity, uint32_t stateDim)
+    {
+        NS_ASSERT(!IsOpen());
+        NS_ASSERT(capacity > 0);
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared ring needs lock-free 64-bit atomics");
+        m_capacity = 1;
+        while (m_capacity < capacity) {
+            m_capacity <<= 1;
+        }
+        m_stateDim = stateDim;
+        m_recordSize = (RECORD_HEADER_SIZE + stateDim * sizeof(float) + 7) / 8 * 8;
+        m_size = sizeof(RingHeader) + (size_t) m_capacity * m_recordSize;
+
+        int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open shared memory segment " + name + ": " + std::strerror(errno));
+        }
+        if (ftruncate(fd, m_size) != 0) {
+            close(fd);
+            throw std::runtime_error("Cannot size shared memory segment " + name + ": " + std::strerror(errno));
+        }
+        void *base = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) {
+            throw std::runtime_error("Cannot map shared memory segment " + name + ": " + std::strerror(errno));
+        }
+        m_name = name;
+        m_base = static_cast<uint8_t *>(base);
+        m_header = reinterpret_cast<RingHeader *>(m_base);
+        m_records = m_base + sizeof(RingHeader);
+
+        //!< The magic is written last so a learner never sees a half-initialized header
+        m_header->magic = 0;
+        m_header->version = VERSION;
+        m_header->recordSize = m_recordSize;
+        m_header->capacity = m_capacity;
+        m_header->stateDim = m_stateDim;
+        m_header->reserved = 0;
+        new (&m_header->head) std::atomic<uint64_t>(0);
+        new (&m_header->tail) std::atomic<uint64_t>(0);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_header->magic = MAGIC;
+        NS_LOG_INFO ("Experience ring " << name << " with " << m_capacity << " records of " << m_recordSize << " bytes");
+    }
+
+    bool
+    ExperienceRingBuffer::IsOpen (void) const
+    {
+        return m_base != nullptr;
+    }
+
+    void
+    ExperienceRingBuffer::Close (void)
+    {
+        //!< The segment is left in place for the learner to drain, it unlinks it when done
+        if (m_base != nullptr) {
+            munmap(m_base, m_size);
+            m_base = nullptr;
+            m_header = nullptr;
+            m_records = nullptr;
+        }
+    }
+
+    bool
+    ExperienceRingBuffer::Push (uint32_t satelliteId, uint32_t action, int64_t timeNs, float reward,
+                                const uint8_t mask[4], const float probability[4], const float *state)
+    {
+        NS_ASSERT(IsOpen());
+        uint64_t head = m_header->head.load(std::memory_order_relaxed);
+        uint64_t tail = m_header->tail.load(std::memory_order_acquire);
+        if (head - tail >= m_capacity) {
+            m_dropped++;
+            return false;
+        }
+        uint8_t *record = m_records + (size_t) (head & (m_capacity - 1)) * m_recordSize;
+        std::memcpy(record, &satelliteId, 4);
+        std::memcpy(record + 4, &action, 4);
+        std::memcpy(record + 8, &timeNs, 8);
+        std::memcpy(record + 16, &reward, 4);
+        std::memcpy(record + 20, mask, 4);
+        std::memcpy(record + 24, probability, 16);
+        std::memcpy(record + RECORD_HEADER_SIZE, state, m_stateDim * sizeof(float));
+        m_header->head.store(head + 1, std::memory_order_release);
+        m_pushed++;
+        return true;
+    }
+
+    uint32_t
+    ExperienceRingBuffer::GetStateDim (void) const
+    {
+        return m_stateDim;
+    }
+
+    uint64_t
+    ExperienceRingBuffer::GetNumPushed (void) const
+    {
+        return m_pushed;
+    }
+
+    uint64_t
+    ExperienceRingBuffer::GetNumDropped (void) const
+    {
+        return m_dropped;
+    }
+
+}
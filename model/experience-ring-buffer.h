@@ -0,0 +1,132 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#ifndef SATELLITE_NETWORK_EXPERIENCE_RING_BUFFER_H
+#define SATELLITE_NETWORK_EXPERIENCE_RING_BUFFER_H
+
+#include "ns3/object.h"
+#include <atomic>
+#include <string>
+
+namespace ns3 {
+
+    /**
+     * Single-producer/single-consumer ring of experiences in POSIX shared memory.
+     *
+     * The simulator appends one record per policy query and never blocks: a record is
+     * dropped when the ring is full. A learner maps the same segment (/dev/shm/<name>)
+     * and drains it at its own pace, see RLRouting/experience_ring.py.
+     *
+     * Binary layout, little endian:
+     *
+     *   offset  size  field
+     *   0       4     magic 0x50584C52 ("RLXP")
+     *   4       4     version (1)
+     *   8       4     record size in bytes
+     *   12      4     capacity in records (power of two)
+     *   16      4     state dimension in float32 (5 x 56)
+     *   20      4     reserved
+     *   64      8     head: records published, written by the simulator
+     *   128     8     tail: records consumed, written by the learner
+     *   192     ...   records, record n at 192 + (n mod capacity) * record size
+     *
+     * Record:
+     *
+     *   0       4     uint32 satellite id
+     *   4       4     uint32 action chosen by sampling (direction 0..3)
+     *   8       8     int64 simulation time (ns)
+     *   16      4     float32 reward returned to the agent with this query
+     *   20      4     uint8[4] mask (priority + 2 * feasible per direction)
+     *   24      16    float32[4] probability of the four directions
+     *   40      4*D   float32[D] state: own link state, then tables from neighbors 0..3
+     *
+     * A record is complete once head has moved past it; the learner must copy it out
+     * before advancing tail.
+     */
+    class ExperienceRingBuffer : public Object
+    {
+    public:
+        static TypeId GetTypeId (void);
+
+        static const uint32_t MAGIC = 0x50584C52;
+        static const uint32_t VERSION = 1;
+        static const uint32_t RECORD_HEADER_SIZE = 40;
+
+        ExperienceRingBuffer ();
+        ~ExperienceRingBuffer ();
+
+        /**
+         * Create (or truncate) the shared memory segment.
+         * @param name      POSIX shared memory name, e.g. "/rl_experience"
+         * @param capacity  number of records, rounded up to a power of two
+         * @param stateDim  number of float32 in the state of one record
+         */
+        void Open (std::string name, uint32_t capacity, uint32_t stateDim);
+
+        bool IsOpen (void) const;
+
+        /**
+         * Append one experience.
+         * @return false if the ring was full and the record was dropped
+         */
+        bool Push (uint32_t satelliteId, uint32_t action, int64_t timeNs, float reward,
+                   const uint8_t mask[4], const float probability[4], const float *state);
+
+        uint32_t GetStateDim (void) const;
+        uint64_t GetNumPushed (void) const;
+        uint64_t GetNumDropped (void) const;
+
+    protected:
+        virtual void DoDispose (void);
+
+    private:
+        struct RingHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t recordSize;
+            uint32_t capacity;
+            uint32_t stateDim;
+            uint32_t reserved;
+            uint8_t padding_0[40];
+            std::atomic<uint64_t> head;
+            uint8_t padding_1[56];
+            std::atomic<uint64_t> tail;
+            uint8_t padding_2[56];
+        };
+        static_assert(sizeof(RingHeader) == 192, "Ring header layout is part of the protocol");
+
+        void Close (void);
+        std::string m_name;
+        uint8_t *m_base;
+        size_t m_size;
+        RingHeader *m_header;
+        uint8_t *m_records;
+        uint32_t m_recordSize;
+        uint32_t m_capacity;
+        uint32_t m_stateDim;
+        uint64_t m_pushed;
+        uint64_t m_dropped;
+    };
+
+}
+
+#endif //SATELLITE_NETWORK_EXPERIENCE_RING_BUFFER_H
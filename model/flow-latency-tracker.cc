@@ -0,0 +1,235 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "flow-latency-tracker.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/udp-header.h"
+#include "ns3/udp-l4-protocol.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace ns3 {
+
+    NS_LOG_COMPONENT_DEFINE ("FlowLatencyTracker");
+    NS_OBJECT_ENSURE_REGISTERED (FlowLatencyTag);
+    NS_OBJECT_ENSURE_REGISTERED (FlowLatencyTracker);
+
+    TypeId
+    FlowLatencyTag::GetTypeId (void)
+    {
+        static TypeId tid = TypeId ("ns3::FlowLatencyTag")
+                .SetParent<Tag> ()
+                .SetGroupName("RoutingRL")
+                .AddConstructor<FlowLatencyTag> ()
+        ;
+        return tid;
+    }
+
+    TypeId
+    FlowLatencyTag::GetInstanceTypeId (void) const
+    {
+        return GetTypeId ();
+    }
+
+    uint32_t
+    FlowLatencyTag::GetSerializedSize (void) const
+    {
+        return sizeof(int64_t) + sizeof(uint32_t);
+    }
+
+    void
+    FlowLatencyTag::Serialize (TagBuffer i) const
+    {
+        i.WriteU64((uint64_t) m_sendTimeNs);
+        i.WriteU32(m_flowIndex);
+    }
+
+    void
+    FlowLatencyTag::Deserialize (TagBuffer i)
+    {
+        m_sendTimeNs = (int64_t) i.ReadU64();
+        m_flowIndex = i.ReadU32();
+    }
+
+    void
+    FlowLatencyTag::Print (std::ostream &os) const
+    {
+        os << "sendTimeNs=" << m_sendTimeNs << " flowIndex=" << m_flowIndex;
+    }
+
+    void
+    FlowLatencyTag::SetSendTimeNs (int64_t sendTimeNs)
+    {
+        m_sendTimeNs = sendTimeNs;
+    }
+
+    int64_t
+    FlowLatencyTag::GetSendTimeNs (void) const
+    {
+        return m_sendTimeNs;
+    }
+
+    void
+    FlowLatencyTag::SetFlowIndex (uint32_t flowIndex)
+    {
+        m_flowIndex = flowIndex;
+    }
+
+    uint32_t
+    FlowLatencyTag::GetFlowIndex (void) const
+    {
+        return m_flowIndex;
+    }
+
+    TypeId
+    FlowLatencyTracker::GetTypeId (void)
+    {
+        static TypeId tid = TypeId ("ns3::FlowLatencyTracker")
+                .SetParent<Object> ()
+                .SetGroupName("RoutingRL")
+        ;
+        return tid;
+    }
+
+    FlowLatencyTracker::FlowLatencyTracker (NodeContainer nodes, std::string percentilesFilename, std::string histogramsFilename)
+    {
+        m_percentilesFilename = percentilesFilename;
+        m_histogramsFilename = histogramsFilename;
+        for (uint32_t i = 0; i < nodes.GetN(); i++) {
+            Ptr<Ipv4L3Protocol> ipv4 = nodes.Get(i)->GetObject<Ipv4L3Protocol>();
+            if (ipv4 == nullptr) {
+                throw std::runtime_error("Node " + std::to_string(nodes.Get(i)->GetId()) + " has no IPv4 stack to track latency on.");
+            }
+            ipv4->TraceConnectWithoutContext("SendOutgoing", MakeCallback(&FlowLatencyTracker::PacketSent, this));
+            ipv4->TraceConnectWithoutContext("LocalDeliver", MakeCallback(&FlowLatencyTracker::PacketDelivered, this));
+        }
+        //!< The destroy event holds a reference, so the tracker lives until the results are written
+        Simulator::ScheduleDestroy(&FlowLatencyTracker::WriteResults, Ptr<FlowLatencyTracker>(this));
+    }
+
+    FlowLatencyTracker::~FlowLatencyTracker ()
+    {
+    }
+
+    void
+    FlowLatencyTracker::DoDispose (void)
+    {
+        m_flowIndex.clear();
+        m_flows.clear();
+        Object::DoDispose();
+    }
+
+    void
+    FlowLatencyTracker::PacketSent (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface)
+    {
+        if (header.GetProtocol() != UdpL4Protocol::PROT_NUMBER) {
+            return;
+        }
+        UdpHeader udpHeader;
+        packet->PeekHeader(udpHeader);
+        FlowKey key(header.GetSource().Get(), header.GetDestination().Get(),
+                    udpHeader.GetSourcePort(), udpHeader.GetDestinationPort());
+        std::unordered_map<FlowKey, uint32_t, FlowKeyHash>::iterator iter = m_flowIndex.find(key);
+        if (iter == m_flowIndex.end()) {
+            iter = m_flowIndex.insert({key, (uint32_t) m_flows.size()}).first;
+            m_flows.push_back(Flow{key, LatencyHistogram(), LatencyHistogram(), -1});
+        }
+        //!< Only AddPacketTag is const; a packet already tagged keeps the time it was first sent
+        FlowLatencyTag tag;
+        if (packet->PeekPacketTag(tag)) {
+            return;
+        }
+        tag.SetSendTimeNs(Simulator::Now().GetNanoSeconds());
+        tag.SetFlowIndex(iter->second);
+        packet->AddPacketTag(tag);
+    }
+
+    void
+    FlowLatencyTracker::PacketDelivered (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface)
+    {
+        FlowLatencyTag tag;
+        if (!packet->PeekPacketTag(tag)) {
+            return;
+        }
+        Flow &flow = m_flows.at(tag.GetFlowIndex());
+        int64_t delayNs = Simulator::Now().GetNanoSeconds() - tag.GetSendTimeNs();
+        flow.delay.Record((uint64_t) delayNs);
+        if (flow.lastDelayNs >= 0) {
+            flow.jitter.Record((uint64_t) std::abs(delayNs - flow.lastDelayNs));
+        }
+        flow.lastDelayNs = delayNs;
+    }
+
+    void
+    FlowLatencyTracker::WriteResults ()
+    {
+        std::ofstream percentiles(m_percentilesFilename, std::ofstream::out | std::ofstream::trunc);
+        std::ofstream histograms(m_histogramsFilename, std::ofstream::out | std::ofstream::trunc);
+        if (!percentiles.is_open() || !histograms.is_open()) {
+            throw std::runtime_error("Cannot open flow latency results " + m_percentilesFilename);
+        }
+        //!< Delays and jitters in ns; the histograms of equal flows from several runs can be summed bucket by bucket
+        percentiles << "flow_id,source_ip,destination_ip,source_port,destination_port,kind,count,min,mean,p50,p90,p99,p99.9,max" << std::endl;
+        histograms << "flow_id,kind,sub_bucket_bits,num_buckets,buckets" << std::endl;
+        for (uint32_t i = 0; i < m_flows.size(); i++) {
+            const Flow &flow = m_flows[i];
+            std::ostringstream source;
+            std::ostringstream destination;
+            Ipv4Address(std::get<0>(flow.key)).Print(source);
+            Ipv4Address(std::get<1>(flow.key)).Print(destination);
+            for (int kind = 0; kind < 2; kind++) {
+                const LatencyHistogram &histogram = kind == 0 ? flow.delay : flow.jitter;
+                const char *name = kind == 0 ? "delay" : "jitter";
+                percentiles << i << "," << source.str() << "," << destination.str() << ","
+                            << std::get<2>(flow.key) << "," << std::get<3>(flow.key) << "," << name << ","
+                            << histogram.GetCount() << "," << histogram.GetMin() << "," << histogram.GetMean() << ","
+                            << histogram.GetValueAtQuantile(0.5) << "," << histogram.GetValueAtQuantile(0.9) << ","
+                            << histogram.GetValueAtQuantile(0.99) << "," << histogram.GetValueAtQuantile(0.999) << ","
+                            << histogram.GetMax() << std::endl;
+                histograms << i << "," << name << "," << LatencyHistogram::SUB_BUCKET_BITS << ","
+                           << LatencyHistogram::NUM_BUCKETS << "," << histogram.BucketsToString() << std::endl;
+            }
+        }
+    }
+
+    uint32_t
+    FlowLatencyTracker::GetNumFlows () const
+    {
+        return m_flows.size();
+    }
+
+    const LatencyHistogram &
+    FlowLatencyTracker::GetDelayHistogram (uint32_t flowIndex) const
+    {
+        return m_flows.at(flowIndex).delay;
+    }
+
+    const LatencyHistogram &
+    FlowLatencyTracker::GetJitterHistogram (uint32_t flowIndex) const
+    {
+        return m_flows.at(flowIndex).jitter;
+    }
+
+}
@@ -0,0 +1,129 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#ifndef SATELLITE_NETWORK_FLOW_LATENCY_TRACKER_H
+#define SATELLITE_NETWORK_FLOW_LATENCY_TRACKER_H
+
+#include "ns3/object.h"
+#include "ns3/tag.h"
+#include "ns3/node-container.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/packet.h"
+#include "latency-histogram.h"
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * Send time and flow of a packet, added by the FlowLatencyTracker at its source.
+     */
+    class FlowLatencyTag : public Tag
+    {
+    public:
+        static TypeId GetTypeId (void);
+        virtual TypeId GetInstanceTypeId (void) const;
+        virtual uint32_t GetSerializedSize (void) const;
+        virtual void Serialize (TagBuffer i) const;
+        virtual void Deserialize (TagBuffer i);
+        virtual void Print (std::ostream &os) const;
+
+        void SetSendTimeNs (int64_t sendTimeNs);
+        int64_t GetSendTimeNs (void) const;
+        void SetFlowIndex (uint32_t flowIndex);
+        uint32_t GetFlowIndex (void) const;
+
+    private:
+        int64_t m_sendTimeNs;
+        uint32_t m_flowIndex;
+    };
+
+    /**
+     * One-way delay and jitter histograms of every UDP flow between the tracked nodes.
+     *
+     * A flow is identified by its addresses and ports. The flow is looked up once when a packet
+     * leaves its source, the tag carries its index to the destination, so a delivery costs two
+     * histogram updates. Jitter is the absolute difference between the delays of consecutive
+     * packets of a flow. Results are written when the simulator is destroyed.
+     */
+    class FlowLatencyTracker : public Object
+    {
+    public:
+        static TypeId GetTypeId (void);
+
+        /**
+         * @param nodes  nodes the flows start and end at
+         * @param percentilesFilename  CSV of count, mean and percentiles per flow
+         * @param histogramsFilename  CSV of the non-empty buckets per flow
+         */
+        FlowLatencyTracker (NodeContainer nodes, std::string percentilesFilename, std::string histogramsFilename);
+        ~FlowLatencyTracker ();
+
+        /**
+         * Trace sink of Ipv4L3Protocol::SendOutgoing.
+         */
+        void PacketSent (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface);
+
+        /**
+         * Trace sink of Ipv4L3Protocol::LocalDeliver.
+         */
+        void PacketDelivered (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface);
+
+        /**
+         * Write both files.
+         */
+        void WriteResults ();
+
+        uint32_t GetNumFlows () const;
+        const LatencyHistogram &GetDelayHistogram (uint32_t flowIndex) const;
+        const LatencyHistogram &GetJitterHistogram (uint32_t flowIndex) const;
+
+    protected:
+        virtual void DoDispose (void);
+
+    private:
+        //!< source address, destination address, source port, destination port
+        typedef std::tuple<uint32_t, uint32_t, uint16_t, uint16_t> FlowKey;
+        struct FlowKeyHash {
+            size_t operator() (const FlowKey &key) const
+            {
+                uint64_t addresses = ((uint64_t) std::get<0>(key) << 32) | std::get<1>(key);
+                uint64_t ports = ((uint64_t) std::get<2>(key) << 16) | std::get<3>(key);
+                return std::hash<uint64_t>()(addresses * 0x9E3779B97F4A7C15ULL ^ ports);
+            }
+        };
+        struct Flow {
+            FlowKey key;
+            LatencyHistogram delay;
+            LatencyHistogram jitter;
+            int64_t lastDelayNs;    //!< delay of the previous packet, -1 before the first one
+        };
+        std::unordered_map<FlowKey, uint32_t, FlowKeyHash> m_flowIndex;
+        std::vector<Flow> m_flows;
+        std::string m_percentilesFilename;
+        std::string m_histogramsFilename;
+    };
+
+}
+
+#endif //SATELLITE_NETWORK_FLOW_LATENCY_TRACKER_H
@@ -0,0 +1,220 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "fluid-traffic-model.h"
+#include "terminal-attachment-table.h"
+#include "constellation-tick-scheduler.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace ns3 {
+
+    NS_LOG_COMPONENT_DEFINE ("FluidTrafficModel");
+    NS_OBJECT_ENSURE_REGISTERED (FluidTrafficModel);
+
+    TypeId
+    FluidTrafficModel::GetTypeId (void)
+    {
+        static TypeId tid = TypeId ("ns3::FluidTrafficModel")
+                .SetParent<Object> ()
+                .SetGroupName("RoutingRL")
+        ;
+        return tid;
+    }
+
+    FluidTrafficModel::FluidTrafficModel (Ptr<TopologySatellite> topology, Ptr<ShortestPathTable> shortestPaths,
+                                          double intraRateBps, double interRateBps, uint32_t maxQueuePackets, uint32_t packetSizeByte)
+    {
+        NS_ASSERT(intraRateBps > 0 && interRateBps > 0 && packetSizeByte > 0);
+        m_topology = topology;
+        m_shortestPaths = shortestPaths;
+        m_intraRateBps = intraRateBps;
+        m_interRateBps = interRateBps;
+        m_maxQueuePackets = maxQueuePackets;
+        m_packetSizeByte = packetSizeByte;
+        m_activeFlows = 0;
+        m_lastUpdateNs = 0;
+        uint32_t numSatellites = shortestPaths->GetNumNodes();
+        m_devices = std::vector<Ptr<LaserNetDevice>>(numSatellites * 4);
+        m_load = std::vector<double>(numSatellites * 4, 0.0);
+        m_backlogByte = std::vector<double>(numSatellites * 4, 0.0);
+        m_queueEstimate = std::vector<double>(numSatellites * 4, 0.0);
+    }
+
+    FluidTrafficModel::~FluidTrafficModel ()
+    {
+    }
+
+    void
+    FluidTrafficModel::DoDispose (void)
+    {
+        //!< Aggregated to the topology it points to, break the cycle
+        m_topology = nullptr;
+        m_shortestPaths = nullptr;
+        m_devices.clear();
+        Object::DoDispose();
+    }
+
+    void
+    FluidTrafficModel::ReadSchedule (const std::string &filename)
+    {
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            throw std::runtime_error("Cannot open fluid schedule " + filename);
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty()) {
+                continue;
+            }
+            std::vector<std::string> fields;
+            std::istringstream in(line);
+            std::string field;
+            while (std::getline(in, field, ',')) {
+                fields.push_back(field);
+            }
+            if (fields.size() < 6) {
+                throw std::runtime_error("Fluid schedule line \"" + line + "\" has fewer than 6 fields");
+            }
+            uint32_t from = std::stoul(fields[1]);
+            uint32_t to = std::stoul(fields[2]);
+            if (from >= m_topology->GetNodes().GetN() || to >= m_topology->GetNodes().GetN()) {
+                throw std::runtime_error("Fluid schedule line \"" + line + "\" has an unknown node");
+            }
+            AddFlow(from, to, std::stod(fields[3]) * 1e6, std::stoll(fields[4]), std::stoll(fields[5]));
+        }
+    }
+
+    void
+    FluidTrafficModel::AddFlow (uint32_t from, uint32_t to, double rateBps, int64_t startNs, int64_t durationNs)
+    {
+        m_flows.push_back(Flow{from, to, rateBps, startNs, startNs + durationNs});
+    }
+
+    void
+    FluidTrafficModel::SetLinkDevice (uint32_t satellite, uint32_t direction, Ptr<LaserNetDevice> device)
+    {
+        NS_ASSERT(direction < 4);
+        m_devices.at(satellite * 4 + direction) = device;
+    }
+
+    double
+    FluidTrafficModel::GetCapacity (uint32_t link) const
+    {
+        uint32_t satellite = link / 4;
+        if (!m_shortestPaths->IsLinkUp(satellite, m_shortestPaths->GetNeighbor(satellite, link % 4))) {
+            return 0.0;
+        }
+        if (m_devices[link] != nullptr) {
+            return (double) m_devices[link]->GetDataRate().GetBitRate();
+        }
+        return link % 4 < 2 ? m_intraRateBps : m_interRateBps;
+    }
+
+    void
+    FluidTrafficModel::Start (Time step)
+    {
+        Update();
+        Ptr<ConstellationTickScheduler> ticks = ConstellationTickScheduler::Get();
+        ticks->Subscribe(ticks->GetTaskClass("UpdateFluidTraffic", step, step),
+                         MakeCallback(&FluidTrafficModel::Update, this));
+    }
+
+    uint32_t
+    FluidTrafficModel::GetServingSatellite (uint32_t node) const
+    {
+        if (m_topology == nullptr || m_topology->IsSatelliteId(node)) {
+            return node;
+        }
+        return m_topology->GetObject<TerminalAttachmentTable>()->GetServingSatellite(node);
+    }
+
+    void
+    FluidTrafficModel::Update ()
+    {
+        int64_t now = Simulator::Now().GetNanoSeconds();
+        double elapsed = (now - m_lastUpdateNs) * 1e-9;
+        uint32_t numSatellites = m_shortestPaths->GetNumNodes();
+
+        //!< Queues evolve under the loads of the last step
+        double maxQueueByte = (double) m_maxQueuePackets * m_packetSizeByte;
+        for (uint32_t link = 0; link < m_load.size(); link++) {
+            double capacity = GetCapacity(link);
+            m_backlogByte[link] = std::min(maxQueueByte, std::max(0.0, m_backlogByte[link] + (m_load[link] - capacity) * elapsed / 8.0));
+        }
+
+        //!< Loads of the next step, each flow along the first shortest next hop
+        std::fill(m_load.begin(), m_load.end(), 0.0);
+        m_activeFlows = 0;
+        for (const Flow &flow : m_flows) {
+            if (now < flow.startNs || now >= flow.endNs) {
+                continue;
+            }
+            m_activeFlows++;
+            uint32_t node = GetServingSatellite(flow.from);
+            uint32_t target = GetServingSatellite(flow.to);
+            for (uint32_t hops = 0; node != target && hops < numSatellites; hops++) {
+                uint8_t mask = m_shortestPaths->GetNextHopMask(node, target);
+                if (mask == 0) {
+                    break;
+                }
+                uint32_t direction = __builtin_ctz(mask);
+                //!< Only the four grid ISLs of a satellite are modeled, a cross-shell hop adds no load
+                if (direction < 4) {
+                    m_load[node * 4 + direction] += flow.rateBps;
+                }
+                node = m_shortestPaths->GetNeighbor(node, direction);
+            }
+        }
+
+        for (uint32_t link = 0; link < m_load.size(); link++) {
+            //!< Nothing leaves a queue without capacity
+            double capacity = GetCapacity(link);
+            double rho = capacity > 0.0 ? m_load[link] / capacity : 1.0;
+            double waiting = rho < 1.0 ? rho * rho / (2.0 * (1.0 - rho)) : (double) m_maxQueuePackets;
+            m_queueEstimate[link] = std::min((double) m_maxQueuePackets, m_backlogByte[link] / m_packetSizeByte + waiting);
+        }
+        m_lastUpdateNs = now;
+    }
+
+    double
+    FluidTrafficModel::GetLoad (uint32_t satellite, uint32_t direction) const
+    {
+        return m_load.at(satellite * 4 + direction);
+    }
+
+    uint32_t
+    FluidTrafficModel::GetNumFlows () const
+    {
+        return m_flows.size();
+    }
+
+    uint32_t
+    FluidTrafficModel::GetNumActiveFlows () const
+    {
+        return m_activeFlows;
+    }
+
+}
@@ -0,0 +1,139 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#ifndef SATELLITE_NETWORK_FLUID_TRAFFIC_MODEL_H
+#define SATELLITE_NETWORK_FLUID_TRAFFIC_MODEL_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/topology-satellites.h"
+#include "ns3/laser-net-device.h"
+#include "shortest-path-table.h"
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * Background UDP bursts modeled as fluid rates on the ISLs instead of packets.
+     *
+     * Every step, each active fluid flow adds its rate to the directed ISLs of its static route
+     * between the satellites serving its two ends. The queue of every directed ISL is then
+     * estimated from its load: the fluid backlog builds up while the load exceeds the capacity,
+     * and below capacity the M/D/1 mean queue length of fixed size packets is added. The capacity is
+     * the current rate of the ISL device once registered, and 0 while the shortest path table has
+     * the ISL down, so that its queue then reads full. The arbiters
+     * add these estimates to the queues they measure, so only the probe flows left in the packet
+     * schedule go through the packet path.
+     *
+     * Flows are read from a file in the format of the UDP burst schedule:
+     * id,from_node,to_node,rate_megabit_per_s,start_ns,duration_ns,additional_params,metadata
+     */
+    class FluidTrafficModel : public Object
+    {
+    public:
+        static TypeId GetTypeId (void);
+
+        /**
+         * @param topology  topology of the constellation, null if every flow is between satellites
+         * @param shortestPaths  static routes the fluid flows follow and state of the ISLs
+         * @param intraRateBps  capacity of the ISLs within an orbit (directions 0, 1) without a device
+         * @param interRateBps  capacity of the ISLs between orbits (directions 2, 3) without a device
+         * @param maxQueuePackets  size of the ISL queues
+         * @param packetSizeByte  size of the packets the rates are made of
+         */
+        FluidTrafficModel (Ptr<TopologySatellite> topology, Ptr<ShortestPathTable> shortestPaths,
+                           double intraRateBps, double interRateBps, uint32_t maxQueuePackets, uint32_t packetSizeByte);
+        ~FluidTrafficModel ();
+
+        /**
+         * Add the flows of a schedule file.
+         */
+        void ReadSchedule (const std::string &filename);
+
+        /**
+         * Add a flow between two nodes, terminals are mapped to their serving satellites.
+         */
+        void AddFlow (uint32_t from, uint32_t to, double rateBps, int64_t startNs, int64_t durationNs);
+
+        /**
+         * Take the capacity of the ISL of a satellite in a direction from the rate of its device.
+         */
+        void SetLinkDevice (uint32_t satellite, uint32_t direction, Ptr<LaserNetDevice> device);
+
+        /**
+         * Route the flows and update the queue estimates now and then every step.
+         */
+        void Start (Time step);
+
+        /**
+         * Advance the queue estimates to now with the current flows.
+         */
+        void Update ();
+
+        /**
+         * @return estimated packets in the queue of the ISL of a satellite in a direction
+         */
+        double GetQueueEstimate (uint32_t satellite, uint32_t direction) const
+        {
+            return m_queueEstimate[satellite * 4 + direction];
+        }
+
+        /**
+         * @return fluid load of the ISL of a satellite in a direction, in bit/s
+         */
+        double GetLoad (uint32_t satellite, uint32_t direction) const;
+
+        uint32_t GetNumFlows () const;
+        uint32_t GetNumActiveFlows () const;
+
+    protected:
+        virtual void DoDispose (void);
+
+    private:
+        struct Flow {
+            uint32_t from;
+            uint32_t to;
+            double rateBps;
+            int64_t startNs;
+            int64_t endNs;
+        };
+        uint32_t GetServingSatellite (uint32_t node) const;
+        double GetCapacity (uint32_t link) const;
+        Ptr<TopologySatellite> m_topology;
+        Ptr<ShortestPathTable> m_shortestPaths;
+        double m_intraRateBps;
+        double m_interRateBps;
+        uint32_t m_maxQueuePackets;
+        uint32_t m_packetSizeByte;
+        std::vector<Ptr<LaserNetDevice>> m_devices;      //!< [satellite * 4 + direction], null uses the configured rate
+        std::vector<Flow> m_flows;
+        uint32_t m_activeFlows;
+        int64_t m_lastUpdateNs;
+        std::vector<double> m_load;             //!< [satellite * 4 + direction], bit/s
+        std::vector<double> m_backlogByte;      //!< [satellite * 4 + direction]
+        std::vector<double> m_queueEstimate;    //!< [satellite * 4 + direction], packets
+    };
+
+}
+
+#endif //SATELLITE_NETWORK_FLUID_TRAFFIC_MODEL_H
@@ -0,0 +1,135 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "graph-observation.h"
+#include "reinforcement-learning-single-forward.h"
+
+namespace ns3 {
+
+    namespace {
+
+        const float THOUSAND = 1000.0f;
+        const float DISTANCE_NORMALIZED = 2000000.0f;
+
+        //!< Where a node is read from: table holding its position, slot of the position in that table,
+        //!< table and slot of its service link counters.
+        struct NodeSource {
+            uint32_t table;
+            uint32_t position;
+            uint32_t serviceTable;
+            uint32_t serviceLink;
+        };
+
+        //!< Node 4 reads the service link counters of node 3, as the trained models expect.
+        const NodeSource NODE_SOURCES[GraphObservation::NUM_NODES] = {
+                {0, 0, 0, 0}, {1, 0, 1, 0}, {2, 0, 2, 0}, {3, 0, 3, 0}, {4, 0, 3, 0},
+                {1, 1, 1, 1}, {1, 3, 1, 3}, {1, 4, 1, 4},
+                {2, 2, 2, 2}, {2, 3, 2, 3}, {2, 4, 2, 4},
+                {3, 3, 3, 3}, {4, 4, 4, 4}
+        };
+
+        //!< Where an edge is read from: table of its source node and direction of the ISL in it.
+        struct EdgeSource {
+            uint32_t table;
+            uint32_t direction;
+            int64_t from;
+            int64_t to;
+        };
+
+        const EdgeSource EDGE_SOURCES[GraphObservation::NUM_EDGES] = {
+                {0, 0, 0, 1}, {0, 1, 0, 2}, {0, 2, 0, 3}, {0, 3, 0, 4},
+                {1, 0, 1, 5}, {1, 2, 1, 6}, {1, 3, 1, 7},
+                {2, 1, 2, 8}, {2, 2, 2, 9}, {2, 3, 2, 10},
+                {3, 0, 3, 6}, {3, 1, 3, 9}, {3, 2, 3, 11},
+                {4, 0, 4, 7}, {4, 1, 4, 10}, {4, 3, 4, 12}
+        };
+
+    }
+
+    GraphObservation::GraphObservation()
+    {
+        m_node_features = std::vector<float>(NUM_NODES * DIM_NODE_FEATURE, 0.0f);
+        m_edge_features = std::vector<float>(NUM_EDGES * DIM_EDGE_FEATURE, 0.0f);
+    }
+
+    void
+    GraphObservation::Build(const float *observation, const std::vector<uint32_t> &finalMask)
+    {
+        for (uint32_t n = 0; n < NUM_NODES; ++n) {
+            const NodeSource &source = NODE_SOURCES[n];
+            const float *table = observation + source.table * FEATURE_SIZE;
+            const float *serviceTable = observation + source.serviceTable * FEATURE_SIZE;
+            float *node = &m_node_features[n * DIM_NODE_FEATURE];
+            node[0] = table[FEATURE_POSITION + 2 * source.position];
+            node[1] = table[FEATURE_POSITION + 2 * source.position + 1];
+            node[2] = serviceTable[FEATURE_SL_SENT + source.serviceLink] / THOUSAND;
+            node[3] = serviceTable[FEATURE_SL_RECEIVED + source.serviceLink] / THOUSAND;
+        }
+        //!< Only node 0 carries the action masks, the other rows keep their zeros
+        for (uint32_t i = 0; i < 4; ++i) {
+            m_node_features[4 + i] = (finalMask.at(i) & 1) ? 1.0f : 0.0f;
+            m_node_features[8 + i] = (finalMask.at(i) & 2) ? 1.0f : 0.0f;
+        }
+
+        for (uint32_t e = 0; e < NUM_EDGES; ++e) {
+            const float *table = observation + EDGE_SOURCES[e].table * FEATURE_SIZE;
+            uint32_t d = EDGE_SOURCES[e].direction;
+            float *edge = &m_edge_features[e * DIM_EDGE_FEATURE];
+            edge[0] = table[FEATURE_DATA_RATE + d];
+            edge[1] = table[FEATURE_IDLE_RATIO + d];
+            edge[2] = table[FEATURE_DISTANCE + d] / DISTANCE_NORMALIZED;
+            edge[3] = table[FEATURE_RELATIVE_SPEED + d];
+            edge[4] = table[FEATURE_ISL_SENT + d] / THOUSAND;
+            edge[5] = table[FEATURE_ISL_RECEIVED + d] / THOUSAND;
+            edge[6] = table[FEATURE_BUSYNESS + d];
+            edge[7] = table[FEATURE_QUEUE_LENGTH + d];
+            edge[8] = table[FEATURE_CHANNEL_QUALITY + d];
+        }
+    }
+
+    const std::vector<float> &
+    GraphObservation::GetNodeFeatures() const
+    {
+        return m_node_features;
+    }
+
+    const std::vector<float> &
+    GraphObservation::GetEdgeFeatures() const
+    {
+        return m_edge_features;
+    }
+
+    const std::vector<int64_t> &
+    GraphObservation::GetEdgeIndex()
+    {
+        static const std::vector<int64_t> edge_index = [] {
+            std::vector<int64_t> index(2 * NUM_EDGES);
+            for (uint32_t e = 0; e < NUM_EDGES; ++e) {
+                index[e] = EDGE_SOURCES[e].from;
+                index[NUM_EDGES + e] = EDGE_SOURCES[e].to;
+            }
+            return index;
+        }();
+        return edge_index;
+    }
+
+}
@@ -0,0 +1,82 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#ifndef SATELLITE_NETWORK_GRAPH_OBSERVATION_H
+#define SATELLITE_NETWORK_GRAPH_OBSERVATION_H
+
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * Graph input of the GNN policy, built from the observation block of an arbiter.
+     *
+     *                       node5
+     *                         |
+     *              node6---node1---node7
+     *                |       |      |
+     *     node11---node3---node0---node4---node12
+     *                |       |      |
+     *              node9---node2---node10
+     *                        |
+     *                      node8
+     *
+     * Node features (13 x 12, row major): latitude, longitude, service link packets sent and
+     * received / 1000, then for node 0 the priority and feasible masks of the four actions.
+     * Edge features (16 x 9, row major): data rate, idle ratio, distance / 2000 km, relative speed,
+     * ISL packets sent and received / 1000, busyness, queue length, channel quality.
+     * The layout matches Graph_data_construction in RLRouting/utils.py.
+     */
+    class GraphObservation
+    {
+    public:
+        static const uint32_t NUM_NODES = 13;
+        static const uint32_t NUM_EDGES = 16;
+        static const uint32_t DIM_NODE_FEATURE = 12;
+        static const uint32_t DIM_EDGE_FEATURE = 9;
+
+        GraphObservation();
+
+        /**
+         * Fill node and edge features.
+         * @param observation five link-state tables of 56 features, mine first
+         * @param finalMask priority + 2 * feasible for each of the four actions
+         */
+        void Build(const float *observation, const std::vector<uint32_t> &finalMask);
+
+        const std::vector<float> &GetNodeFeatures() const;
+        const std::vector<float> &GetEdgeFeatures() const;
+
+        /**
+         * @return source node ids followed by target node ids (2 x 16), fixed for all satellites
+         */
+        static const std::vector<int64_t> &GetEdgeIndex();
+
+    private:
+        std::vector<float> m_node_features;
+        std::vector<float> m_edge_features;
+    };
+
+}
+
+#endif //SATELLITE_NETWORK_GRAPH_OBSERVATION_H
@@ -0,0 +1,136 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "isl-utilization-recorder.h"
+#include "ns3/ipv4.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include <cstring>
+#include <fstream>
+
+namespace ns3 {
+
+    NS_LOG_COMPONENT_DEFINE ("IslUtilizationRecorder");
+    NS_OBJECT_ENSURE_REGISTERED (IslUtilizationRecorder);
+
+    TypeId
+    IslUtilizationRecorder::GetTypeId (void)
+    {
+        static TypeId tid = TypeId ("ns3::IslUtilizationRecorder")
+                .SetParent<Object> ()
+                .SetGroupName("RoutingRL")
+        ;
+        return tid;
+    }
+
+    IslUtilizationRecorder::IslUtilizationRecorder (Ptr<TopologySatellite> topology, Time binWidth, Time duration, std::string filename)
+    {
+        NS_ASSERT(binWidth.IsStrictlyPositive());
+        m_binWidthNs = binWidth.GetNanoSeconds();
+        m_numBins = std::max((int64_t) 1, (duration.GetNanoSeconds() + m_binWidthNs - 1) / m_binWidthNs);
+        m_numLinks = 2 * topology->GetNumUndirectedEdges();
+        m_filename = filename;
+        m_bytes = std::vector<uint32_t>((size_t) m_numLinks * m_numBins, 0);
+        m_packets = std::vector<uint32_t>((size_t) m_numLinks * m_numBins, 0);
+        const std::vector<std::pair<uint32_t, uint32_t>>& interface_idxs_for_undirected_edges = topology->GetInterfaceIdxsForUndirectedEdges();
+        for (int i = 0; i < topology->GetNumUndirectedEdges(); i++) {
+            std::pair<int64_t, int64_t> edge = topology->GetUndirectedEdges().at(i);
+            m_links.push_back({(uint32_t) edge.first, (uint32_t) edge.second});
+            m_links.push_back({(uint32_t) edge.second, (uint32_t) edge.first});
+            Ptr<NetDevice> devices[2] = {
+                    topology->GetNodes().Get(edge.first)->GetObject<Ipv4>()->GetNetDevice(interface_idxs_for_undirected_edges.at(i).first),
+                    topology->GetNodes().Get(edge.second)->GetObject<Ipv4>()->GetNetDevice(interface_idxs_for_undirected_edges.at(i).second)
+            };
+            for (uint32_t k = 0; k < 2; k++) {
+                if (!devices[k]->TraceConnectWithoutContext("PhyTxBegin", MakeBoundCallback(&IslUtilizationRecorder::PacketTransmitted, this, 2 * i + k))) {
+                    throw std::runtime_error("ISL device of edge " + std::to_string(i) + " has no PhyTxBegin trace source.");
+                }
+            }
+        }
+        //!< The destroy event holds a reference, so the recorder lives until the results are written
+        Simulator::ScheduleDestroy(&IslUtilizationRecorder::WriteResults, Ptr<IslUtilizationRecorder>(this));
+    }
+
+    IslUtilizationRecorder::~IslUtilizationRecorder ()
+    {
+    }
+
+    void
+    IslUtilizationRecorder::DoDispose (void)
+    {
+        m_bytes.clear();
+        m_packets.clear();
+        Object::DoDispose();
+    }
+
+    void
+    IslUtilizationRecorder::PacketTransmitted (IslUtilizationRecorder *recorder, uint32_t link, Ptr<const Packet> packet)
+    {
+        int64_t bin = Simulator::Now().GetNanoSeconds() / recorder->m_binWidthNs;
+        size_t slot = (size_t) link * recorder->m_numBins + std::min(bin, (int64_t) recorder->m_numBins - 1);
+        recorder->m_bytes[slot] += packet->GetSize();
+        recorder->m_packets[slot]++;
+    }
+
+    void
+    IslUtilizationRecorder::WriteResults ()
+    {
+        std::ofstream file(m_filename, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Cannot open ISL utilization file " + m_filename);
+        }
+        uint32_t header[8] = {MAGIC, VERSION, m_numLinks, m_numBins, 0, 0, 0, 0};
+        std::memcpy(&header[4], &m_binWidthNs, sizeof(int64_t));
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+        for (const std::pair<uint32_t, uint32_t> &link : m_links) {
+            uint32_t ids[2] = {link.first, link.second};
+            file.write(reinterpret_cast<const char *>(ids), sizeof(ids));
+        }
+        file.write(reinterpret_cast<const char *>(m_bytes.data()), m_bytes.size() * sizeof(uint32_t));
+        file.write(reinterpret_cast<const char *>(m_packets.data()), m_packets.size() * sizeof(uint32_t));
+    }
+
+    uint32_t
+    IslUtilizationRecorder::GetNumLinks () const
+    {
+        return m_numLinks;
+    }
+
+    uint32_t
+    IslUtilizationRecorder::GetNumBins () const
+    {
+        return m_numBins;
+    }
+
+    uint32_t
+    IslUtilizationRecorder::GetBytes (uint32_t link, uint32_t bin) const
+    {
+        return m_bytes.at((size_t) link * m_numBins + bin);
+    }
+
+    uint32_t
+    IslUtilizationRecorder::GetPackets (uint32_t link, uint32_t bin) const
+    {
+        return m_packets.at((size_t) link * m_numBins + bin);
+    }
+
+}
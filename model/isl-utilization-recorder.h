@@ -0,0 +1,89 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#ifndef SATELLITE_NETWORK_ISL_UTILIZATION_RECORDER_H
+#define SATELLITE_NETWORK_ISL_UTILIZATION_RECORDER_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/topology-satellites.h"
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * Bytes and packets sent over every directed ISL, accumulated into fixed-width time bins.
+     *
+     * Directed link 2k is edge k of the topology from its first to its second node, 2k+1 the other
+     * way. The link x bin counters are allocated up front for the whole simulation, a transmission
+     * costs two increments. Written when the simulator is destroyed as one binary file:
+     *
+     *   header (32 bytes): magic 0x49534C55 ("ISLU"), version, links, bins (u32), bin width ns (i64), reserved
+     *   links x (from, to) node ids (u32)
+     *   links x bins bytes (u32), then links x bins packets (u32), link-major
+     */
+    class IslUtilizationRecorder : public Object
+    {
+    public:
+        static TypeId GetTypeId (void);
+
+        static const uint32_t MAGIC = 0x49534C55;
+        static const uint32_t VERSION = 1;
+
+        /**
+         * @param topology  topology whose ISL devices are followed
+         * @param binWidth  width of a time bin
+         * @param duration  simulated time to allocate bins for, later transmissions go to the last bin
+         * @param filename  binary file written at the end of the run
+         */
+        IslUtilizationRecorder (Ptr<TopologySatellite> topology, Time binWidth, Time duration, std::string filename);
+        ~IslUtilizationRecorder ();
+
+        /**
+         * Trace sink of PhyTxBegin of the device of a directed link.
+         */
+        static void PacketTransmitted (IslUtilizationRecorder *recorder, uint32_t link, Ptr<const Packet> packet);
+
+        void WriteResults ();
+
+        uint32_t GetNumLinks () const;
+        uint32_t GetNumBins () const;
+        uint32_t GetBytes (uint32_t link, uint32_t bin) const;
+        uint32_t GetPackets (uint32_t link, uint32_t bin) const;
+
+    protected:
+        virtual void DoDispose (void);
+
+    private:
+        int64_t m_binWidthNs;
+        uint32_t m_numLinks;
+        uint32_t m_numBins;
+        std::vector<std::pair<uint32_t, uint32_t>> m_links;    //!< (from, to) node ids of every directed link
+        std::vector<uint32_t> m_bytes;      //!< link-major, m_numBins per link
+        std::vector<uint32_t> m_packets;    //!< link-major, m_numBins per link
+        std::string m_filename;
+    };
+
+}
+
+#endif //SATELLITE_NETWORK_ISL_UTILIZATION_RECORDER_H
@@ -0,0 +1,134 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "latency-histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+namespace ns3 {
+
+    LatencyHistogram::LatencyHistogram ()
+    {
+        m_buckets = std::vector<uint64_t>(NUM_BUCKETS, 0);
+        m_count = 0;
+        m_sum = 0;
+        m_min = std::numeric_limits<uint64_t>::max();
+        m_max = 0;
+    }
+
+    void
+    LatencyHistogram::Merge (const LatencyHistogram &other)
+    {
+        for (uint32_t i = 0; i < NUM_BUCKETS; i++) {
+            m_buckets[i] += other.m_buckets[i];
+        }
+        m_count += other.m_count;
+        m_sum += other.m_sum;
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    uint64_t
+    LatencyHistogram::GetBucketLowerBound (uint32_t index)
+    {
+        if (index < 2 * HALF_BUCKET_COUNT) {
+            return index;
+        }
+        uint32_t shift = index / HALF_BUCKET_COUNT - 1;
+        return ((uint64_t) (index - shift * HALF_BUCKET_COUNT)) << shift;
+    }
+
+    uint64_t
+    LatencyHistogram::GetBucketWidth (uint32_t index)
+    {
+        if (index < 2 * HALF_BUCKET_COUNT) {
+            return 1;
+        }
+        return ((uint64_t) 1) << (index / HALF_BUCKET_COUNT - 1);
+    }
+
+    uint64_t
+    LatencyHistogram::GetValueAtQuantile (double quantile) const
+    {
+        if (m_count == 0) {
+            return 0;
+        }
+        //!< Rank of the value, 1-based, the first one for quantile 0
+        uint64_t rank = std::max((uint64_t) 1, (uint64_t) std::ceil(quantile * m_count));
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < NUM_BUCKETS; i++) {
+            seen += m_buckets[i];
+            if (seen >= rank) {
+                uint64_t value = GetBucketLowerBound(i) + GetBucketWidth(i) / 2;
+                return std::min(std::max(value, m_min), m_max);
+            }
+        }
+        return m_max;
+    }
+
+    uint64_t
+    LatencyHistogram::GetCount () const
+    {
+        return m_count;
+    }
+
+    uint64_t
+    LatencyHistogram::GetMin () const
+    {
+        return m_count == 0 ? 0 : m_min;
+    }
+
+    uint64_t
+    LatencyHistogram::GetMax () const
+    {
+        return m_max;
+    }
+
+    double
+    LatencyHistogram::GetMean () const
+    {
+        return m_count == 0 ? 0.0 : (double) m_sum / m_count;
+    }
+
+    const std::vector<uint64_t> &
+    LatencyHistogram::GetBuckets () const
+    {
+        return m_buckets;
+    }
+
+    std::string
+    LatencyHistogram::BucketsToString () const
+    {
+        std::ostringstream out;
+        bool first = true;
+        for (uint32_t i = 0; i < NUM_BUCKETS; i++) {
+            if (m_buckets[i] != 0) {
+                out << (first ? "" : ";") << i << ":" << m_buckets[i];
+                first = false;
+            }
+        }
+        return out.str();
+    }
+
+}
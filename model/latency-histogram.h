@@ -0,0 +1,110 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#ifndef SATELLITE_NETWORK_LATENCY_HISTOGRAM_H
+#define SATELLITE_NETWORK_LATENCY_HISTOGRAM_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * Log-linear histogram of nanosecond values with fixed memory, in the manner of HdrHistogram.
+     *
+     * Values below 2^SUB_BUCKET_BITS get a bucket each, above that every power of two is split into
+     * 2^(SUB_BUCKET_BITS-1) buckets, so the relative error of a reported value stays below 1/64.
+     * Values above the largest trackable one (about 137 s) are counted in the last bucket.
+     * Histograms with the same layout are merged by adding their bucket arrays.
+     */
+    class LatencyHistogram
+    {
+    public:
+        static const uint32_t SUB_BUCKET_BITS = 7;
+        static const uint32_t MAX_VALUE_BITS = 37;
+        static const uint32_t HALF_BUCKET_COUNT = 1u << (SUB_BUCKET_BITS - 1);
+        static const uint32_t NUM_BUCKETS = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 2) * HALF_BUCKET_COUNT;
+
+        LatencyHistogram ();
+
+        void Record (uint64_t valueNs)
+        {
+            m_buckets[GetBucketIndex(valueNs)]++;
+            m_count++;
+            m_sum += valueNs;
+            m_min = valueNs < m_min ? valueNs : m_min;
+            m_max = valueNs > m_max ? valueNs : m_max;
+        }
+
+        void Merge (const LatencyHistogram &other);
+
+        /**
+         * @param quantile  in [0, 1]
+         * @return value at the quantile, the middle of its bucket, 0 if empty
+         */
+        uint64_t GetValueAtQuantile (double quantile) const;
+
+        uint64_t GetCount () const;
+        uint64_t GetMin () const;
+        uint64_t GetMax () const;
+        double GetMean () const;
+        const std::vector<uint64_t> &GetBuckets () const;
+
+        /**
+         * @return non-empty buckets as "index:count" separated by ';'
+         */
+        std::string BucketsToString () const;
+
+        static uint32_t GetBucketIndex (uint64_t valueNs)
+        {
+            if (valueNs >> MAX_VALUE_BITS) {
+                return NUM_BUCKETS - 1;
+            }
+            if (valueNs < (1u << SUB_BUCKET_BITS)) {
+                return (uint32_t) valueNs;
+            }
+            uint32_t shift = (63 - __builtin_clzll(valueNs)) - (SUB_BUCKET_BITS - 1);
+            return shift * HALF_BUCKET_COUNT + (uint32_t) (valueNs >> shift);
+        }
+
+        /**
+         * @return smallest value counted in a bucket
+         */
+        static uint64_t GetBucketLowerBound (uint32_t index);
+
+        /**
+         * @return number of values counted in a bucket
+         */
+        static uint64_t GetBucketWidth (uint32_t index);
+
+    private:
+        std::vector<uint64_t> m_buckets;
+        uint64_t m_count;
+        uint64_t m_sum;
+        uint64_t m_min;
+        uint64_t m_max;
+    };
+
+}
+
+#endif //SATELLITE_NETWORK_LATENCY_HISTOGRAM_H
@@ -0,0 +1,162 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "link-geometry-table.h"
+#include "constellation-tick-scheduler.h"
+#include "parallel-for.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+    NS_LOG_COMPONENT_DEFINE ("LinkGeometryTable");
+    NS_OBJECT_ENSURE_REGISTERED (LinkGeometryTable);
+
+    //!< Speed of light in vacuum, m/s
+    static const double SPEED_OF_LIGHT = 299792458.0;
+
+    TypeId
+    LinkGeometryTable::GetTypeId (void)
+    {
+        static TypeId tid = TypeId ("ns3::LinkGeometryTable")
+                .SetParent<Object> ()
+                .SetGroupName("RoutingRL")
+        ;
+        return tid;
+    }
+
+    LinkGeometryTable::LinkGeometryTable (Ptr<TopologySatellite> topology, Time step)
+    {
+        NS_ASSERT(step.IsStrictlyPositive());
+        m_topology = topology;
+        m_step = step;
+        m_sampleTime = Seconds(0);
+        for (int i = 0; i < topology->GetNumUndirectedEdges(); i++) {
+            std::pair<int64_t, int64_t> edge = topology->GetUndirectedEdges().at(i);
+            uint32_t a = std::min(edge.first, edge.second);
+            uint32_t b = std::max(edge.first, edge.second);
+            m_links.push_back({a, b});
+            m_linkIndex[((uint64_t) a << 32) | b] = i;
+        }
+        m_positionsStart = std::vector<Vector>(topology->GetNumSatellites());
+        m_positionsEnd = std::vector<Vector>(topology->GetNumSatellites());
+        m_distance = std::vector<double>(m_links.size(), 0.0);
+        m_rangeRate = std::vector<double>(m_links.size(), 0.0);
+        m_relativeSpeed = std::vector<double>(m_links.size(), 0.0);
+    }
+
+    LinkGeometryTable::~LinkGeometryTable ()
+    {
+    }
+
+    void
+    LinkGeometryTable::DoDispose (void)
+    {
+        //!< Aggregated to the topology it points to, break the cycle
+        m_topology = nullptr;
+        Object::DoDispose();
+    }
+
+    void
+    LinkGeometryTable::Propagate (Time time, std::vector<Vector> &positions)
+    {
+        //!< Propagation is independent per satellite
+        ParallelFor(ConstellationTickScheduler::Get()->GetNumThreads(), positions.size(), [this, time, &positions] (uint32_t i) {
+            Ptr<Satellite> satellite = m_topology->GetSatellite(i);
+            positions[i] = satellite->GetPosition(satellite->GetTleEpoch () + time);
+        });
+    }
+
+    void
+    LinkGeometryTable::Start ()
+    {
+        m_sampleTime = Simulator::Now();
+        Propagate(m_sampleTime, m_positionsEnd);
+        Refresh();
+        Ptr<ConstellationTickScheduler> ticks = ConstellationTickScheduler::Get();
+        ticks->Subscribe(ticks->GetTaskClass("RefreshLinkGeometry", m_step, m_step),
+                         MakeCallback(&LinkGeometryTable::Refresh, this));
+    }
+
+    void
+    LinkGeometryTable::Refresh ()
+    {
+        //!< The end of the last step is where this one starts, only the new end is propagated
+        std::swap(m_positionsStart, m_positionsEnd);
+        m_sampleTime = Simulator::Now();
+        Propagate(m_sampleTime + m_step, m_positionsEnd);
+        double step = m_step.GetSeconds();
+        for (uint32_t k = 0; k < m_links.size(); k++) {
+            const Vector &a0 = m_positionsStart[m_links[k].first];
+            const Vector &b0 = m_positionsStart[m_links[k].second];
+            const Vector &a1 = m_positionsEnd[m_links[k].first];
+            const Vector &b1 = m_positionsEnd[m_links[k].second];
+            double d0 = CalculateDistance(a0, b0);
+            double d1 = CalculateDistance(a1, b1);
+            Vector change((b1.x - a1.x) - (b0.x - a0.x), (b1.y - a1.y) - (b0.y - a0.y), (b1.z - a1.z) - (b0.z - a0.z));
+            m_distance[k] = d0;
+            m_rangeRate[k] = (d1 - d0) / step;
+            m_relativeSpeed[k] = std::sqrt(change.x * change.x + change.y * change.y + change.z * change.z) / step;
+        }
+    }
+
+    uint32_t
+    LinkGeometryTable::GetLinkIndex (uint32_t a, uint32_t b) const
+    {
+        std::unordered_map<uint64_t, uint32_t>::const_iterator iter =
+                m_linkIndex.find(((uint64_t) std::min(a, b) << 32) | std::max(a, b));
+        return iter == m_linkIndex.end() ? NOT_A_LINK : iter->second;
+    }
+
+    Time
+    LinkGeometryTable::GetDelay (uint32_t link) const
+    {
+        return Seconds(GetDistance(link) / SPEED_OF_LIGHT);
+    }
+
+    double
+    LinkGeometryTable::GetRangeRate (uint32_t link) const
+    {
+        return m_rangeRate.at(link);
+    }
+
+    double
+    LinkGeometryTable::GetRelativeSpeed (uint32_t link) const
+    {
+        return m_relativeSpeed.at(link);
+    }
+
+    uint32_t
+    LinkGeometryTable::GetNumLinks () const
+    {
+        return m_links.size();
+    }
+
+    Time
+    LinkGeometryTable::GetStep () const
+    {
+        return m_step;
+    }
+
+}
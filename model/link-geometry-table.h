@@ -0,0 +1,119 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#ifndef SATELLITE_NETWORK_LINK_GEOMETRY_TABLE_H
+#define SATELLITE_NETWORK_LINK_GEOMETRY_TABLE_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+#include "ns3/vector.h"
+#include "ns3/topology-satellites.h"
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * Distance, propagation delay, range rate and relative speed of every ISL, sampled at a fixed
+     * step and linearly interpolated in between.
+     *
+     * One periodic event propagates all satellites to the end of the next step and keeps the
+     * positions of the previous sample, so a lookup is an interpolation between two distances with
+     * no mobility model call. Links are the undirected edges of the topology, looked up by edge index
+     * or by their two ends.
+     */
+    class LinkGeometryTable : public Object
+    {
+    public:
+        static TypeId GetTypeId (void);
+
+        static const uint32_t NOT_A_LINK = 0xFFFFFFFF;
+
+        /**
+         * @param topology  topology of the constellation
+         * @param step  time between two samples
+         */
+        LinkGeometryTable (Ptr<TopologySatellite> topology, Time step);
+        ~LinkGeometryTable ();
+
+        /**
+         * Take the first samples now and then refresh every step.
+         */
+        void Start ();
+
+        /**
+         * Shift the samples by one step: the end of the current step becomes its start.
+         */
+        void Refresh ();
+
+        /**
+         * @return edge index of the ISL between a and b, NOT_A_LINK if there is none
+         */
+        uint32_t GetLinkIndex (uint32_t a, uint32_t b) const;
+
+        /**
+         * @return distance between the two ends of an ISL now, in m
+         */
+        double GetDistance (uint32_t link) const
+        {
+            return m_distance[link] + m_rangeRate[link] * (Simulator::Now() - m_sampleTime).GetSeconds();
+        }
+
+        /**
+         * @return propagation delay of an ISL now
+         */
+        Time GetDelay (uint32_t link) const;
+
+        /**
+         * @return rate of change of the distance of an ISL over the current step, in m/s
+         */
+        double GetRangeRate (uint32_t link) const;
+
+        /**
+         * @return norm of the relative velocity of the two ends of an ISL over the current step, in m/s
+         */
+        double GetRelativeSpeed (uint32_t link) const;
+
+        uint32_t GetNumLinks () const;
+        Time GetStep () const;
+
+    protected:
+        virtual void DoDispose (void);
+
+    private:
+        void Propagate (Time time, std::vector<Vector> &positions);
+        Ptr<TopologySatellite> m_topology;
+        Time m_step;
+        Time m_sampleTime;                              //!< time of the sample at the start of the current step
+        std::vector<std::pair<uint32_t, uint32_t>> m_links;
+        std::unordered_map<uint64_t, uint32_t> m_linkIndex;     //!< (min end << 32 | max end) -> edge index
+        std::vector<Vector> m_positionsStart;           //!< satellites at m_sampleTime
+        std::vector<Vector> m_positionsEnd;             //!< satellites at m_sampleTime + m_step
+        std::vector<double> m_distance;                 //!< at m_sampleTime
+        std::vector<double> m_rangeRate;
+        std::vector<double> m_relativeSpeed;
+    };
+
+}
+
+#endif //SATELLITE_NETWORK_LINK_GEOMETRY_TABLE_H
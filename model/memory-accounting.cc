@@ -0,0 +1,168 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "memory-accounting.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+namespace ns3 {
+
+    std::atomic<int64_t> MemoryAccounting::s_current[(size_t) MemoryCategory::NUM_CATEGORIES] = {};
+    std::atomic<int64_t> MemoryAccounting::s_peak[(size_t) MemoryCategory::NUM_CATEGORIES] = {};
+
+    MemoryAccount::MemoryAccount ()
+    {
+        m_current.fill(0);
+        m_peak.fill(0);
+    }
+
+    void
+    MemoryAccount::Add (MemoryCategory category, int64_t bytes)
+    {
+        size_t c = (size_t) category;
+        m_current[c] += bytes;
+        m_peak[c] = std::max(m_peak[c], m_current[c]);
+    }
+
+    int64_t
+    MemoryAccount::GetCurrent (MemoryCategory category) const
+    {
+        return m_current[(size_t) category];
+    }
+
+    int64_t
+    MemoryAccount::GetPeak (MemoryCategory category) const
+    {
+        return m_peak[(size_t) category];
+    }
+
+    int64_t
+    MemoryAccount::GetTotal () const
+    {
+        int64_t total = 0;
+        for (int64_t bytes : m_current) {
+            total += bytes;
+        }
+        return total;
+    }
+
+    void
+    MemoryAccounting::Add (MemoryCategory category, int64_t bytes, MemoryAccount *account)
+    {
+        size_t c = (size_t) category;
+        int64_t current = s_current[c].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        int64_t peak = s_peak[c].load(std::memory_order_relaxed);
+        while (current > peak && !s_peak[c].compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+        }
+        if (account != nullptr) {
+            account->Add(category, bytes);
+        }
+    }
+
+    int64_t
+    MemoryAccounting::GetCurrent (MemoryCategory category)
+    {
+        return s_current[(size_t) category].load(std::memory_order_relaxed);
+    }
+
+    int64_t
+    MemoryAccounting::GetPeak (MemoryCategory category)
+    {
+        return s_peak[(size_t) category].load(std::memory_order_relaxed);
+    }
+
+    std::string
+    MemoryAccounting::GetCategoryName (MemoryCategory category)
+    {
+        switch (category) {
+            case MemoryCategory::ROUTING_TABLES:
+                return "routing_tables";
+            case MemoryCategory::LINK_STATE:
+                return "link_state";
+            case MemoryCategory::DYNAMIC_ROUTES:
+                return "dynamic_routes";
+            case MemoryCategory::PENDING_ACTIONS:
+                return "pending_actions";
+            case MemoryCategory::QUEUE_TRACKING:
+                return "queue_tracking";
+            case MemoryCategory::OBJECTS:
+                return "objects";
+            default:
+                throw std::runtime_error("Unknown memory category");
+        }
+    }
+
+    void
+    MemoryAccounting::WriteReport (const std::string &reportFilename, const std::string &ownersFilename,
+                                   const std::vector<const MemoryAccount *> &owners)
+    {
+        std::ofstream report(reportFilename, std::ofstream::out | std::ofstream::trunc);
+        std::ofstream perOwner(ownersFilename, std::ofstream::out | std::ofstream::trunc);
+        if (!report.is_open() || !perOwner.is_open()) {
+            throw std::runtime_error("Cannot open memory report " + reportFilename);
+        }
+        const uint32_t numCategories = (uint32_t) MemoryCategory::NUM_CATEGORIES;
+        report << "Memory per category (bytes)" << std::endl;
+        report << "category,current,peak" << std::endl;
+        int64_t totalCurrent = 0;
+        for (uint32_t c = 0; c < numCategories; c++) {
+            MemoryCategory category = (MemoryCategory) c;
+            report << GetCategoryName(category) << "," << GetCurrent(category) << "," << GetPeak(category) << std::endl;
+            totalCurrent += GetCurrent(category);
+        }
+        report << "total," << totalCurrent << ",-" << std::endl;
+        report << std::endl;
+
+        //!< Distribution of the peaks over the owners, with the owner of the maximum to find outliers
+        report << "Peak per satellite (bytes), over " << owners.size() << " satellites" << std::endl;
+        report << "category,min,mean,p50,p99,max,argmax" << std::endl;
+        std::vector<std::pair<int64_t, uint32_t>> peaks(owners.size());
+        for (uint32_t c = 0; c < numCategories && !owners.empty(); c++) {
+            MemoryCategory category = (MemoryCategory) c;
+            double sum = 0;
+            for (uint32_t i = 0; i < owners.size(); i++) {
+                peaks[i] = {owners[i]->GetPeak(category), i};
+                sum += peaks[i].first;
+            }
+            std::sort(peaks.begin(), peaks.end());
+            report << GetCategoryName(category) << "," << peaks.front().first << "," << sum / owners.size() << ","
+                   << peaks[(peaks.size() - 1) / 2].first << "," << peaks[(peaks.size() - 1) * 99 / 100].first << ","
+                   << peaks.back().first << "," << peaks.back().second << std::endl;
+        }
+
+        perOwner << "satellite";
+        for (uint32_t c = 0; c < numCategories; c++) {
+            std::string name = GetCategoryName((MemoryCategory) c);
+            perOwner << "," << name << "_current," << name << "_peak";
+        }
+        perOwner << std::endl;
+        for (uint32_t i = 0; i < owners.size(); i++) {
+            perOwner << i;
+            for (uint32_t c = 0; c < numCategories; c++) {
+                perOwner << "," << owners[i]->GetCurrent((MemoryCategory) c) << "," << owners[i]->GetPeak((MemoryCategory) c);
+            }
+            perOwner << std::endl;
+        }
+    }
+
+}
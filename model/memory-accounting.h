@@ -0,0 +1,162 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#ifndef SATELLITE_NETWORK_MEMORY_ACCOUNTING_H
+#define SATELLITE_NETWORK_MEMORY_ACCOUNTING_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * What the memory of the module is used for.
+     */
+    enum class MemoryCategory : uint32_t {
+        ROUTING_TABLES = 0,     //!< shared next-hop and distance tables
+        LINK_STATE = 1,         //!< observation blocks gathered from neighbors
+        DYNAMIC_ROUTES = 2,     //!< installed policy outputs, their rewards and expiry queue
+        PENDING_ACTIONS = 3,    //!< packets waiting for a reward and outstanding policy queries
+        QUEUE_TRACKING = 4,     //!< occupancy bins of the ISL queues
+        OBJECTS = 5,            //!< arbiters and the objects they own
+        NUM_CATEGORIES = 6
+    };
+
+    /**
+     * Current and peak bytes per category of one owner, a satellite for instance.
+     * Only touched by the thread the owner runs on.
+     */
+    class MemoryAccount
+    {
+    public:
+        MemoryAccount ();
+
+        void Add (MemoryCategory category, int64_t bytes);
+        int64_t GetCurrent (MemoryCategory category) const;
+        int64_t GetPeak (MemoryCategory category) const;
+        int64_t GetTotal () const;
+
+    private:
+        std::array<int64_t, (size_t) MemoryCategory::NUM_CATEGORIES> m_current;
+        std::array<int64_t, (size_t) MemoryCategory::NUM_CATEGORIES> m_peak;
+    };
+
+    /**
+     * Module-wide current and peak bytes per category, safe to update from the tick scheduler threads.
+     */
+    class MemoryAccounting
+    {
+    public:
+        /**
+         * Add (or with a negative count remove) bytes of a category, to the totals and to an optional owner.
+         */
+        static void Add (MemoryCategory category, int64_t bytes, MemoryAccount *account = nullptr);
+        static int64_t GetCurrent (MemoryCategory category);
+        static int64_t GetPeak (MemoryCategory category);
+        static std::string GetCategoryName (MemoryCategory category);
+
+        /**
+         * Write the totals per category, then the distribution over the owners, as text,
+         * and the current and peak bytes of every owner and category as CSV.
+         * @param reportFilename  text summary
+         * @param ownersFilename  CSV, one line per owner
+         * @param owners  accounts of the owners, the line of owner i is labelled i
+         */
+        static void WriteReport (const std::string &reportFilename, const std::string &ownersFilename,
+                                 const std::vector<const MemoryAccount *> &owners);
+
+    private:
+        static std::atomic<int64_t> s_current[(size_t) MemoryCategory::NUM_CATEGORIES];
+        static std::atomic<int64_t> s_peak[(size_t) MemoryCategory::NUM_CATEGORIES];
+    };
+
+    /**
+     * Standard allocator counting what it hands out under a category, and under the account of
+     * its owner if it has one. Containers rebind it, so node based ones count their nodes.
+     */
+    template <typename T>
+    class AccountedAllocator
+    {
+    public:
+        typedef T value_type;
+        typedef std::true_type propagate_on_container_copy_assignment;
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+
+        AccountedAllocator (MemoryAccount *account, MemoryCategory category)
+            : m_account(account), m_category(category)
+        {
+        }
+
+        template <typename U>
+        AccountedAllocator (const AccountedAllocator<U> &other)
+            : m_account(other.GetAccount()), m_category(other.GetCategory())
+        {
+        }
+
+        T *allocate (size_t n)
+        {
+            T *p = std::allocator<T>().allocate(n);
+            MemoryAccounting::Add(m_category, (int64_t) (n * sizeof(T)), m_account);
+            return p;
+        }
+
+        void deallocate (T *p, size_t n)
+        {
+            MemoryAccounting::Add(m_category, -(int64_t) (n * sizeof(T)), m_account);
+            std::allocator<T>().deallocate(p, n);
+        }
+
+        MemoryAccount *GetAccount () const
+        {
+            return m_account;
+        }
+
+        MemoryCategory GetCategory () const
+        {
+            return m_category;
+        }
+
+    private:
+        MemoryAccount *m_account;
+        MemoryCategory m_category;
+    };
+
+    template <typename T, typename U>
+    bool operator== (const AccountedAllocator<T> &a, const AccountedAllocator<U> &b)
+    {
+        return a.GetAccount() == b.GetAccount() && a.GetCategory() == b.GetCategory();
+    }
+
+    template <typename T, typename U>
+    bool operator!= (const AccountedAllocator<T> &a, const AccountedAllocator<U> &b)
+    {
+        return !(a == b);
+    }
+
+}
+
+#endif //SATELLITE_NETWORK_MEMORY_ACCOUNTING_H
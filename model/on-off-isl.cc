@@ -25,6 +25,7 @@
 #include "ns3/satellite-position-helper.h"
 
 #include "ns3/reinforcement-learning-single-forward.h"
+#include "ns3/constellation-tick-scheduler.h"
 
 
 namespace ns3{
@@ -71,16 +72,18 @@ namespace ns3{
 
     FreeSpaceOpticsLossModel::FreeSpaceOpticsLossModel ()
     {
-        m_uniformRandomVariable = CreateObject<UniformRandomVariable>();
-        double min =0.0;
-        double max =1.0;
-        m_uniformRandomVariable->SetAttribute("Min",DoubleValue(min));
-        m_uniformRandomVariable->SetAttribute("Max",DoubleValue(max));
+        m_pointingError = PhiloxRandomStream(RandomStreamDomain::CHANNEL, 0, 0);
     }
     FreeSpaceOpticsLossModel::~FreeSpaceOpticsLossModel()
     {
 
     }
+    void
+    FreeSpaceOpticsLossModel::SetRandomStream(uint32_t nodeA, uint32_t nodeB)
+    {
+        m_pointingError = PhiloxRandomStream(RandomStreamDomain::CHANNEL, nodeA, nodeB);
+    }
+
     void
     FreeSpaceOpticsLossModel::SetResolution(double resolution)
     {
@@ -131,36 +134,35 @@ namespace ns3{
     }
 
     double
-    FreeSpaceOpticsLossModel::DoCalcSNR (Ptr<MobilityModel> a, Ptr<MobilityModel> b)
+    FreeSpaceOpticsLossModel::DoCalcSNR (double distance)
     {
-        double distance = a->GetDistanceFrom (b);
         double numerator = m_lambda * m_lambda;
         double L = numerator / (16 * M_PI * M_PI * distance * distance);
         double Gt = (M_PI * M_PI*m_apertureDiameter*m_apertureDiameter)/numerator;
         double Gr = Gt;
-        double uv_1 = m_uniformRandomVariable->GetValue();
-        double theta_t = std::sqrt(-2*m_resolution*m_resolution*std::log(1-uv_1));
-        double uv_2 = m_uniformRandomVariable->GetValue();
-        double theta_r = std::sqrt(-2*m_resolution*m_resolution*std::log(1-uv_2));
+        double uv[2];
+        m_pointingError.GetUniforms(uv, 2);
+        double theta_t = std::sqrt(-2*m_resolution*m_resolution*std::log(1-uv[0]));
+        double theta_r = std::sqrt(-2*m_resolution*m_resolution*std::log(1-uv[1]));
         double L_t = std::exp(-1*Gt*theta_t*theta_t);
         double L_r = std::exp(-1*Gr*theta_r*theta_r);
         return L*Gt*Gr*L_t*L_r;
     }
 
     double
-    FreeSpaceOpticsLossModel::GetChannelCapacity(Ptr<MobilityModel> a, Ptr<MobilityModel> b, bool is_intraLISL)
+    FreeSpaceOpticsLossModel::GetChannelCapacity(double distance, bool is_intraLISL)
     {
         if(is_intraLISL)
         {
 
             double ratio_Pt_N = 9.285859635948615e4;
-            return m_bandwidth*std::log2(1+ratio_Pt_N*DoCalcSNR(a,b));
+            return m_bandwidth*std::log2(1+ratio_Pt_N*DoCalcSNR(distance));
         }
 
         else
         {
             double ratio_Pt_N = 1.20716175267332e4;
-            return m_bandwidth*std::log2(1+ratio_Pt_N*DoCalcSNR(a,b));
+            return m_bandwidth*std::log2(1+ratio_Pt_N*DoCalcSNR(distance));
         }
     }
 
@@ -179,13 +181,18 @@ namespace ns3{
         m_Device_a = laserChannel->GetLaserDevice(0);
         NS_ASSERT(laserChannel->GetLaserDevice(1));
         m_Device_b = laserChannel->GetLaserDevice(1);
-        /**<meanInterval and meanDuration of SPoF>**/
-        m_faultInterval = CreateObject<ExponentialRandomVariable> ();
+        /**<meanInterval and meanDuration of SPoF, streams are keyed by the ISL>**/
+        uint32_t node_a = m_Device_a->GetNode()->GetId();
+        uint32_t node_b = m_Device_b->GetNode()->GetId();
+        m_faultInterval = PhiloxRandomStream(RandomStreamDomain::FAULT_INTERVAL, node_a, node_b);
+        m_faultDuration = PhiloxRandomStream(RandomStreamDomain::FAULT_DURATION, node_a, node_b);
+        m_meanInterval = meanInterval;
+        m_meanDuration = meanDuration;
+        m_mobility_a = PeekPointer(m_Device_a->GetNode()->GetObject<MobilityModel>());
+        m_mobility_b = PeekPointer(m_Device_b->GetNode()->GetObject<MobilityModel>());
+        NS_ASSERT(m_mobility_a != nullptr && m_mobility_b != nullptr);
         m_FPO_model = CreateObject<FreeSpaceOpticsLossModel>();
-        m_faultInterval->SetAttribute("Mean",DoubleValue (meanInterval));
-        m_faultDuration = CreateObject<NormalRandomVariable>();
-        m_faultDuration->SetAttribute("Mean",DoubleValue (meanDuration));
-        m_faultDuration->SetAttribute("Variance",DoubleValue (25));
+        m_FPO_model->SetRandomStream(node_a, node_b);
         m_state = ISLState::WORK;
         m_isIntraOrbitISL = false;
         m_usingLossModel = usingLoss;
@@ -193,7 +200,13 @@ namespace ns3{
         if(m_usingSPOFModel)
             ScheduleSPOF();
         if(m_usingLossModel)
-            Simulator::Schedule(Seconds(0.0),&PowerLossModel::CalculateChannelCapacity,this);
+        {
+            //!< capacity of all ISLs is computed in one tick, the computation itself is ISL-local
+            Ptr<ConstellationTickScheduler> ticks = ConstellationTickScheduler::Get();
+            ticks->Subscribe(ticks->GetTaskClass("CalculateChannelCapacity", Seconds(0.0), Seconds(10.0)),
+                             MakeCallback(&PowerLossModel::CalculateChannelCapacity, this),
+                             MakeCallback(&PowerLossModel::ApplyChannelCapacity, this));
+        }
     }
 
     PowerLossModel::~PowerLossModel(){
@@ -215,25 +228,27 @@ namespace ns3{
     void
     PowerLossModel::CalculateChannelCapacity()
     {
+        //!< May run on a worker thread: the mobility models are shared by the four ISLs of a satellite,
+        //!< so only their const position reads happen here, no GetObject and no Ptr copies
+        double distance = CalculateDistance(m_mobility_a->GetPosition(), m_mobility_b->GetPosition());
+        m_transmissionRate = m_FPO_model->GetChannelCapacity(distance, m_isIntraOrbitISL);
+    }
 
-        Ptr <MobilityModel> mobility_a = m_Device_a->GetNode()->GetObject<MobilityModel>();
-        Ptr <MobilityModel> mobility_b = m_Device_b->GetNode()->GetObject<MobilityModel>();
-        m_transmissionRate = m_FPO_model->GetChannelCapacity(mobility_a, mobility_b, m_isIntraOrbitISL);
-        //std::cout<<m_Device_a->GetNode()->GetId()<<" -> "<<m_Device_b->GetNode()->GetId()<<" distance: "<< mobility_a->GetDistanceFrom (mobility_b)<<" m"
-        //<<" m_transmissionRate "<<m_transmissionRate/1e6<<" Mbps"<<std::endl;
+    void
+    PowerLossModel::ApplyChannelCapacity()
+    {
         m_Device_a->SetNewDataTransmissionRate(m_transmissionRate);
         m_Device_b->SetNewDataTransmissionRate(m_transmissionRate);
-        Simulator::Schedule(Seconds(10.0), &PowerLossModel::CalculateChannelCapacity, this);
-
+        UpdatingChannelFeatures();
     }
 
     void
     PowerLossModel::ScheduleSPOF() {
         /**<Schedule next break of LISL**/
-        Time errorTime = Seconds(m_faultInterval->GetValue());
+        Time errorTime = Seconds(m_faultInterval.GetExponential(m_meanInterval));
         double duration = 0.0;
         while (duration<=0.0){
-            duration = m_faultDuration->GetValue();
+            duration = m_faultDuration.GetNormal(m_meanDuration, 25);
         }
 
         Time firstDuration = Seconds(duration);
@@ -252,11 +267,11 @@ namespace ns3{
         }
 
         Simulator::Schedule(duration, &PowerLossModel::SPOFEnd,this);
-        Time nextErrorTime = Seconds(m_faultInterval->GetValue());
+        Time nextErrorTime = Seconds(m_faultInterval.GetExponential(m_meanInterval));
 
         double next_duration = 0.0;
         while (next_duration <= 0.0){
-            next_duration = m_faultDuration->GetValue();
+            next_duration = m_faultDuration.GetNormal(m_meanDuration, 25);
         }
         Time nextDuration = Seconds(next_duration);
         nextErrorTime = duration + nextErrorTime;
@@ -303,8 +318,27 @@ namespace ns3{
                 ->GetObject<Ipv4ArbiterRouting>()->GetArbiter()->GetObject<ReinforcementSingleForward>();
         if(node_aSingleForward!=NULL&&node_bSingleForward!=NULL)
         {
+            //!< Repair the next hops that used this ISL (on failure) or that it shortens (on recovery)
+            node_aSingleForward->GetShortestPathTable()->SetLinkState(m_Device_a->GetNode()->GetId(),
+                                                                      m_Device_b->GetNode()->GetId(), !LISLBreak);
             node_aSingleForward->NotifyDisconnection(LISLBreak);
             node_bSingleForward->NotifyDisconnection(LISLBreak);
+            node_aSingleForward->UpdateChannelFeatures();
+            node_bSingleForward->UpdateChannelFeatures();
+        }
+    }
+
+    void
+    PowerLossModel::UpdatingChannelFeatures ()
+    {
+        Ptr <ReinforcementSingleForward> node_aSingleForward = m_Device_a->GetNode()->GetObject<Ipv4>()->GetRoutingProtocol()
+                ->GetObject<Ipv4ArbiterRouting>()->GetArbiter()->GetObject<ReinforcementSingleForward>();
+        Ptr <ReinforcementSingleForward> node_bSingleForward = m_Device_b->GetNode()->GetObject<Ipv4>()->GetRoutingProtocol()
+                ->GetObject<Ipv4ArbiterRouting>()->GetArbiter()->GetObject<ReinforcementSingleForward>();
+        if(node_aSingleForward!=NULL&&node_bSingleForward!=NULL)
+        {
+            node_aSingleForward->UpdateChannelFeatures();
+            node_bSingleForward->UpdateChannelFeatures();
         }
     }
 
@@ -29,6 +29,7 @@
 #include "ns3/ptr.h"
 #include "ns3/double.h"
 #include "ns3/mobility-model.h"
+#include "philox-random-stream.h"
 #include <iostream>
 
 
@@ -110,18 +111,27 @@ namespace ns3 {
         double GetBandwidth(void) const;
 
         /**
+         * \param distance distance between the two terminals (m)
          * \returns the current channel capacity (bps)
          */
-        double GetChannelCapacity (Ptr<MobilityModel> a, Ptr<MobilityModel> b, bool is_intraLISL);
+        double GetChannelCapacity (double distance, bool is_intraLISL);
+
+        /**
+         * \param nodeA first node id of the ISL
+         * \param nodeB second node id of the ISL
+         *
+         * Key the pointing error stream by the ISL.
+         */
+        void SetRandomStream (uint32_t nodeA, uint32_t nodeB);
 
     private:
-        double DoCalcSNR (Ptr<MobilityModel> a, Ptr<MobilityModel> b);
+        double DoCalcSNR (double distance);
         double m_lambda;        //!< the carrier wavelength
         double m_frequency;     //!< the carrier frequency
         double m_resolution;    //!< the resolution of FPO device.
         double m_apertureDiameter; //!< the apertureDiameter of FPO device.
         double m_bandwidth;  //!< the bandwidth of the laser/light.
-        Ptr<UniformRandomVariable> m_uniformRandomVariable;
+        PhiloxRandomStream m_pointingError;  //!< uniform stream of pointing errors
     };
 
     class PowerLossModel : public Object
@@ -134,6 +144,7 @@ namespace ns3 {
         void SetIntraOrInterOrbitISL(bool intraOrbitISL);
         bool IsIntraOrbitISL() const;
         void UpdatingRoutingStrategy(bool disconnection);
+        void UpdatingChannelFeatures();
     private:
         void SPOFEnd();
         void ScheduleSPOF();
@@ -141,11 +152,17 @@ namespace ns3 {
         void ShutDownISL();
         void BootUpISL();
         void CalculateChannelCapacity();
-        Ptr<ExponentialRandomVariable> m_faultInterval;
-        Ptr<NormalRandomVariable> m_faultDuration;
+        void ApplyChannelCapacity();
+        PhiloxRandomStream m_faultInterval;
+        PhiloxRandomStream m_faultDuration;
+        double m_meanInterval;
+        double m_meanDuration;
         ISLState m_state;
         Ptr<LaserNetDevice> m_Device_a;
         Ptr<LaserNetDevice> m_Device_b;
+        //!< Raw pointers taken on the simulator thread, the capacity tick reads positions without touching refcounts
+        const MobilityModel *m_mobility_a;
+        const MobilityModel *m_mobility_b;
         Ptr<FreeSpaceOpticsLossModel> m_FPO_model;
         bool m_isIntraOrbitISL;
         bool m_usingSPOFModel;
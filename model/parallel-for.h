@@ -0,0 +1,177 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#ifndef SATELLITE_NETWORK_PARALLEL_FOR_H
+#define SATELLITE_NETWORK_PARALLEL_FOR_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * Process-wide pool of worker threads behind ParallelFor.
+     *
+     * Workers are started on first use, grown to the largest parallelism asked for, and
+     * sleep between jobs, so a tick costs two wake-ups instead of creating threads. One job
+     * runs at a time; a ParallelFor issued from inside a job runs serially on its thread.
+     */
+    class ParallelWorkers
+    {
+    public:
+        static ParallelWorkers &Get ()
+        {
+            static ParallelWorkers workers;
+            return workers;
+        }
+
+        /**
+         * \returns true on a worker, or on the thread running a job
+         */
+        static bool &InsideJob ()
+        {
+            static thread_local bool inside = false;
+            return inside;
+        }
+
+        /**
+         * Run task(k) for k in [0, numTasks) on the calling thread and up to numTasks - 1 workers,
+         * returning once every task is done.
+         */
+        void Run (uint32_t numTasks, const std::function<void(uint32_t)> &task)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (m_workers.size() + 1 < numTasks) {
+                m_workers.emplace_back(&ParallelWorkers::Loop, this);
+            }
+            m_task = &task;
+            m_numTasks = numTasks;
+            m_next = 0;
+            m_pending = numTasks;
+            m_generation++;
+            m_wake.notify_all();
+            InsideJob() = true;
+            Drain(lock);
+            InsideJob() = false;
+            m_done.wait(lock, [this] () { return m_pending == 0; });
+            m_task = nullptr;
+        }
+
+        ~ParallelWorkers ()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            for (std::thread &worker : m_workers) {
+                worker.join();
+            }
+        }
+
+    private:
+        ParallelWorkers () : m_task(nullptr), m_numTasks(0), m_next(0), m_pending(0), m_generation(0), m_stop(false)
+        {
+        }
+
+        //!< Take tasks of the current job until none is left, called with the lock held
+        void Drain (std::unique_lock<std::mutex> &lock)
+        {
+            while (m_next < m_numTasks) {
+                uint32_t k = m_next++;
+                const std::function<void(uint32_t)> &task = *m_task;
+                lock.unlock();
+                task(k);
+                lock.lock();
+                if (--m_pending == 0) {
+                    m_done.notify_all();
+                }
+            }
+        }
+
+        void Loop ()
+        {
+            InsideJob() = true;
+            std::unique_lock<std::mutex> lock(m_mutex);
+            uint64_t seen = m_generation;
+            while (true) {
+                m_wake.wait(lock, [this, &seen] () { return m_stop || m_generation != seen; });
+                if (m_stop) {
+                    return;
+                }
+                seen = m_generation;
+                Drain(lock);
+            }
+        }
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+        std::vector<std::thread> m_workers;
+        const std::function<void(uint32_t)> *m_task;
+        uint32_t m_numTasks;
+        uint32_t m_next;            //!< next task to hand out
+        uint32_t m_pending;         //!< tasks not finished yet
+        uint64_t m_generation;      //!< incremented per job, wakes the workers
+        bool m_stop;
+    };
+
+    /**
+     * Run function(i) for i in [0, count) on up to numThreads threads, each taking
+     * one contiguous chunk. The calling thread takes part and returns once every
+     * chunk is done. Work must not touch state shared between indices.
+     *
+     * @param numThreads    number of threads including the calling one
+     * @param count         number of indices
+     * @param function      callable taking (uint32_t index)
+     */
+    template <typename F>
+    void
+    ParallelFor (uint32_t numThreads, uint32_t count, F function)
+    {
+        if (numThreads <= 1 || count <= 1 || ParallelWorkers::InsideJob()) {
+            for (uint32_t i = 0; i < count; ++i) {
+                function(i);
+            }
+            return;
+        }
+        if (numThreads > count) {
+            numThreads = count;
+        }
+        uint32_t chunk = (count + numThreads - 1) / numThreads;
+        uint32_t numChunks = (count + chunk - 1) / chunk;
+        ParallelWorkers::Get().Run(numChunks, [chunk, count, &function] (uint32_t k) {
+            uint32_t end = std::min(count, (k + 1) * chunk);
+            for (uint32_t i = k * chunk; i < end; ++i) {
+                function(i);
+            }
+        });
+    }
+
+}
+
+#endif //SATELLITE_NETWORK_PARALLEL_FOR_H
@@ -0,0 +1,127 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "path-tracer.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <fstream>
+
+namespace ns3 {
+
+    NS_LOG_COMPONENT_DEFINE ("PathTracer");
+    NS_OBJECT_ENSURE_REGISTERED (PathTracer);
+
+    TypeId
+    PathTracer::GetTypeId (void)
+    {
+        static TypeId tid = TypeId ("ns3::PathTracer")
+                .SetParent<Object> ()
+                .SetGroupName("RoutingRL")
+        ;
+        return tid;
+    }
+
+    PathTracer::PathTracer (uint32_t sampleOneIn, uint32_t ringSize, uint32_t maxFlows, std::string filename)
+    {
+        NS_ASSERT(sampleOneIn > 0 && ringSize > 0);
+        static_assert(sizeof(Hop) == 24, "Hop records are written as they are laid out in memory");
+        m_sampleOneIn = sampleOneIn;
+        m_ringSize = ringSize;
+        m_maxFlows = maxFlows;
+        m_filename = filename;
+        m_recorded = 0;
+        m_lost = 0;
+        //!< The destroy event holds a reference, so the tracer lives until the results are written
+        Simulator::ScheduleDestroy(&PathTracer::WriteResults, Ptr<PathTracer>(this));
+    }
+
+    PathTracer::~PathTracer ()
+    {
+    }
+
+    void
+    PathTracer::DoDispose (void)
+    {
+        m_flowIndex.clear();
+        m_flows.clear();
+        Object::DoDispose();
+    }
+
+    void
+    PathTracer::RecordHop (uint32_t sourceAddress, uint32_t destinationAddress, uint64_t packetUid,
+                           uint32_t satellite, PathDecisionKind kind, uint8_t direction)
+    {
+        uint64_t key = ((uint64_t) sourceAddress << 32) | destinationAddress;
+        std::unordered_map<uint64_t, uint32_t>::iterator iter = m_flowIndex.find(key);
+        if (iter == m_flowIndex.end()) {
+            if (m_flows.size() >= m_maxFlows) {
+                m_lost++;
+                return;
+            }
+            iter = m_flowIndex.insert({key, (uint32_t) m_flows.size()}).first;
+            m_flows.push_back(Flow{sourceAddress, destinationAddress, 0, std::vector<Hop>(m_ringSize)});
+        }
+        Flow &flow = m_flows[iter->second];
+        flow.ring[flow.numHops % m_ringSize] = Hop{packetUid, Simulator::Now().GetNanoSeconds(), satellite,
+                                                   (uint8_t) kind, direction, 0};
+        flow.numHops++;
+        m_recorded++;
+    }
+
+    void
+    PathTracer::WriteResults ()
+    {
+        std::ofstream file(m_filename, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Cannot open path trace file " + m_filename);
+        }
+        uint32_t header[4] = {MAGIC, VERSION, (uint32_t) m_flows.size(), m_sampleOneIn};
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+        for (const Flow &flow : m_flows) {
+            uint32_t kept = (uint32_t) std::min(flow.numHops, (uint64_t) m_ringSize);
+            uint32_t overwritten = (uint32_t) (flow.numHops - kept);
+            uint32_t flowHeader[4] = {flow.sourceAddress, flow.destinationAddress, kept, overwritten};
+            file.write(reinterpret_cast<const char *>(flowHeader), sizeof(flowHeader));
+            //!< Oldest kept hop first: once the ring wrapped it is the slot written next
+            uint32_t oldest = (uint32_t) (flow.numHops % m_ringSize);
+            if (kept < m_ringSize) {
+                oldest = 0;
+            }
+            file.write(reinterpret_cast<const char *>(flow.ring.data() + oldest), (kept - oldest) * sizeof(Hop));
+            file.write(reinterpret_cast<const char *>(flow.ring.data()), oldest * sizeof(Hop));
+        }
+    }
+
+    uint64_t
+    PathTracer::GetNumRecorded () const
+    {
+        return m_recorded;
+    }
+
+    uint64_t
+    PathTracer::GetNumLost () const
+    {
+        return m_lost;
+    }
+
+}
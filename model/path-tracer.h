@@ -0,0 +1,118 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#ifndef SATELLITE_NETWORK_PATH_TRACER_H
+#define SATELLITE_NETWORK_PATH_TRACER_H
+
+#include "ns3/object.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * How a satellite chose the next hop of a traced packet.
+     */
+    enum class PathDecisionKind : uint8_t {
+        APPROACH = 0,   //!< only one feasible action, towards the target
+        AWAY = 1,       //!< only one feasible action, away from the target
+        DROP = 2,       //!< no feasible action, the packet is forwarded to be dropped
+        RL_CHOSEN = 3,  //!< sampled from the policy
+        STATIC = 4      //!< shortest path, packet not routed by the agent
+    };
+
+    /**
+     * Hops of a sample of the packets, 1 in N chosen by a hash of the packet uid, so every hop of a
+     * sampled packet is recorded and the others cost one multiplication.
+     *
+     * Each flow, identified by its source and destination addresses, keeps its hops in a ring of
+     * fixed size, overwriting the oldest. Written when the simulator is destroyed as one binary file:
+     *
+     *   header (16 bytes): magic 0x50415448 ("PATH"), version, flows, 1 in N (u32)
+     *   per flow: source address, destination address, hops kept, hops overwritten (u32),
+     *             then the kept hops from the oldest, 24 bytes each:
+     *             packet uid (u64), time ns (i64), satellite (u32), kind (u8), direction (u8), 2 bytes padding
+     */
+    class PathTracer : public Object
+    {
+    public:
+        static TypeId GetTypeId (void);
+
+        static const uint32_t MAGIC = 0x50415448;
+        static const uint32_t VERSION = 1;
+
+        struct Hop {
+            uint64_t packetUid;
+            int64_t timeNs;
+            uint32_t satellite;
+            uint8_t kind;
+            uint8_t direction;      //!< direction of the next hop, 0 north, 1 south, 2 west, 3 east, 4+ cross-shell link
+            uint16_t padding;
+        };
+
+        /**
+         * @param sampleOneIn  trace 1 in this many packets
+         * @param ringSize  hops kept per flow
+         * @param maxFlows  flows traced, hops of further flows are counted as lost
+         * @param filename  binary file written at the end of the run
+         */
+        PathTracer (uint32_t sampleOneIn, uint32_t ringSize, uint32_t maxFlows, std::string filename);
+        ~PathTracer ();
+
+        bool IsSampled (uint64_t packetUid) const
+        {
+            //!< Fibonacci hashing, the high bits spread consecutive uids evenly over the residues
+            return ((packetUid * 0x9E3779B97F4A7C15ULL) >> 32) % m_sampleOneIn == 0;
+        }
+
+        void RecordHop (uint32_t sourceAddress, uint32_t destinationAddress, uint64_t packetUid,
+                        uint32_t satellite, PathDecisionKind kind, uint8_t direction);
+
+        void WriteResults ();
+
+        uint64_t GetNumRecorded () const;
+        uint64_t GetNumLost () const;
+
+    protected:
+        virtual void DoDispose (void);
+
+    private:
+        struct Flow {
+            uint32_t sourceAddress;
+            uint32_t destinationAddress;
+            uint64_t numHops;       //!< hops recorded, the ring holds the last m_ringSize
+            std::vector<Hop> ring;
+        };
+        uint32_t m_sampleOneIn;
+        uint32_t m_ringSize;
+        uint32_t m_maxFlows;
+        std::string m_filename;
+        std::unordered_map<uint64_t, uint32_t> m_flowIndex;    //!< source and destination address -> flow
+        std::vector<Flow> m_flows;
+        uint64_t m_recorded;
+        uint64_t m_lost;
+    };
+
+}
+
+#endif //SATELLITE_NETWORK_PATH_TRACER_H
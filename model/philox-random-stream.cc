@@ -0,0 +1,139 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "philox-random-stream.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/assert.h"
+#include <cmath>
+
+namespace ns3 {
+
+    namespace {
+        const uint32_t PHILOX_M0 = 0xD2511F53;
+        const uint32_t PHILOX_M1 = 0xCD9E8D57;
+        const uint32_t PHILOX_W0 = 0x9E3779B9;
+        const uint32_t PHILOX_W1 = 0xBB67AE85;
+        const int PHILOX_ROUNDS = 10;
+    }
+
+    PhiloxRandomStream::PhiloxRandomStream ()
+        : PhiloxRandomStream (RandomStreamDomain::ROUTING, 0, 0)
+    {
+    }
+
+    PhiloxRandomStream::PhiloxRandomStream (RandomStreamDomain domain, uint32_t streamId, uint32_t substreamId)
+    {
+        NS_ASSERT(substreamId < (1u << 24));
+        uint64_t run = RngSeedManager::GetRun();
+        m_key[0] = RngSeedManager::GetSeed();
+        m_key[1] = (uint32_t) (run ^ (run >> 32));
+        m_streamId = streamId;
+        m_substreamDomain = (substreamId << 8) | (uint32_t) domain;
+        m_counter = 0;
+        m_used = 4;
+    }
+
+    void
+    PhiloxRandomStream::Philox4x32 (const uint32_t counter[4], const uint32_t key[2], uint32_t out[4])
+    {
+        uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < PHILOX_ROUNDS; ++round) {
+            uint64_t product_0 = (uint64_t) PHILOX_M0 * c0;
+            uint64_t product_1 = (uint64_t) PHILOX_M1 * c2;
+            uint32_t hi0 = (uint32_t) (product_0 >> 32), lo0 = (uint32_t) product_0;
+            uint32_t hi1 = (uint32_t) (product_1 >> 32), lo1 = (uint32_t) product_1;
+            c0 = hi1 ^ c1 ^ k0;
+            c1 = lo1;
+            c2 = hi0 ^ c3 ^ k1;
+            c3 = lo0;
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+        out[3] = c3;
+    }
+
+    void
+    PhiloxRandomStream::NextBlock ()
+    {
+        uint32_t counter[4] = {(uint32_t) m_counter, (uint32_t) (m_counter >> 32), m_streamId, m_substreamDomain};
+        Philox4x32(counter, m_key, m_block);
+        m_counter++;
+        m_used = 0;
+    }
+
+    double
+    PhiloxRandomStream::ToUniform (uint32_t word)
+    {
+        //!< centre of one of 2^32 cells, never 0 or 1
+        return ((double) word + 0.5) * (1.0 / 4294967296.0);
+    }
+
+    double
+    PhiloxRandomStream::GetUniform ()
+    {
+        if (m_used == 4) {
+            NextBlock();
+        }
+        return ToUniform(m_block[m_used++]);
+    }
+
+    void
+    PhiloxRandomStream::GetUniforms (double *values, uint32_t count)
+    {
+        uint32_t i = 0;
+        while (i < count && m_used < 4) {
+            values[i++] = ToUniform(m_block[m_used++]);
+        }
+        while (i < count) {
+            NextBlock();
+            while (i < count && m_used < 4) {
+                values[i++] = ToUniform(m_block[m_used++]);
+            }
+        }
+    }
+
+    double
+    PhiloxRandomStream::GetExponential (double mean)
+    {
+        return -mean * std::log(GetUniform());
+    }
+
+    double
+    PhiloxRandomStream::GetNormal (double mean, double variance)
+    {
+        double u[2];
+        GetUniforms(u, 2);
+        double z = std::sqrt(-2.0 * std::log(u[0])) * std::cos(2.0 * M_PI * u[1]);
+        return mean + std::sqrt(variance) * z;
+    }
+
+    uint64_t
+    PhiloxRandomStream::GetCounter () const
+    {
+        return m_counter;
+    }
+
+}
@@ -0,0 +1,102 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#ifndef SATELLITE_NETWORK_PHILOX_RANDOM_STREAM_H
+#define SATELLITE_NETWORK_PHILOX_RANDOM_STREAM_H
+
+#include <cstdint>
+
+namespace ns3 {
+
+    //!< Consumers of counter-based random numbers, part of the counter so their streams never overlap.
+    enum class RandomStreamDomain : uint32_t {
+        ROUTING = 0,            //!< action sampling of a satellite
+        CHANNEL = 1,            //!< pointing errors of an ISL
+        FAULT_INTERVAL = 2,     //!< interval between two SPoF of an ISL
+        FAULT_DURATION = 3,     //!< duration of a SPoF of an ISL
+        ROUTE_EXPIRY = 4        //!< lifetime of the dynamic routes of a satellite
+    };
+
+    /**
+     * Counter-based random stream built on Philox4x32-10.
+     *
+     * The key is taken from the ns-3 seed and run number, the counter is made of
+     * (event counter, stream id, substream id, domain). Every draw is a pure function
+     * of these values, so a stream gives the same numbers whatever the order in which
+     * satellites and ISLs are processed.
+     */
+    class PhiloxRandomStream
+    {
+    public:
+        PhiloxRandomStream ();
+
+        /**
+         * @param domain        consumer of the stream
+         * @param streamId      satellite id, or first node id of an ISL
+         * @param substreamId   second node id of an ISL (less than 2^24)
+         */
+        PhiloxRandomStream (RandomStreamDomain domain, uint32_t streamId, uint32_t substreamId = 0);
+
+        /**
+         * One Philox4x32-10 block.
+         */
+        static void Philox4x32 (const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]);
+
+        /**
+         * \returns uniform value in the open interval (0, 1)
+         */
+        double GetUniform ();
+
+        /**
+         * Fill a batch of uniform values in (0, 1), four per block.
+         */
+        void GetUniforms (double *values, uint32_t count);
+
+        /**
+         * \returns exponential value with the given mean
+         */
+        double GetExponential (double mean);
+
+        /**
+         * \returns normal value with the given mean and variance
+         */
+        double GetNormal (double mean, double variance);
+
+        /**
+         * \returns number of blocks generated so far
+         */
+        uint64_t GetCounter () const;
+
+    private:
+        void NextBlock ();
+        static double ToUniform (uint32_t word);
+        uint32_t m_key[2];
+        uint32_t m_streamId;
+        uint32_t m_substreamDomain;
+        uint64_t m_counter;
+        uint32_t m_block[4];
+        uint32_t m_used;        //!< words of m_block already handed out
+    };
+
+}
+
+#endif //SATELLITE_NETWORK_PHILOX_RANDOM_STREAM_H
@@ -0,0 +1,120 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "queue-occupancy-tracker.h"
+#include "ns3/simulator.h"
+#include <algorithm>
+
+namespace ns3 {
+
+    NS_OBJECT_ENSURE_REGISTERED (QueueOccupancyTracker);
+
+    TypeId
+    QueueOccupancyTracker::GetTypeId (void)
+    {
+        static TypeId tid = TypeId ("ns3::QueueOccupancyTracker")
+                .SetParent<Object> ()
+                .SetGroupName("RoutingRL")
+        ;
+        return tid;
+    }
+
+    QueueOccupancyTracker::QueueOccupancyTracker (Ptr<QueueBase> queue, Time window, uint32_t numBins)
+    {
+        NS_ASSERT(queue);
+        NS_ASSERT(numBins > 0 && window.IsStrictlyPositive());
+        m_numBins = numBins;
+        m_binWidth = TimeStep(window.GetTimeStep() / numBins);
+        m_bins = std::vector<double>(numBins, 0.0);
+        m_nextBin = 0;
+        m_windowIntegral = 0.0;
+        m_start = Simulator::Now();
+        m_binStart = m_start;
+        m_lastChange = m_start;
+        m_currentIntegral = 0.0;
+        m_current = queue->GetNPackets();
+        queue->TraceConnectWithoutContext("PacketsInQueue", MakeCallback(&QueueOccupancyTracker::PacketsInQueueChanged, this));
+    }
+
+    QueueOccupancyTracker::~QueueOccupancyTracker ()
+    {
+        // Left empty intentionally
+    }
+
+    void
+    QueueOccupancyTracker::Advance (Time now)
+    {
+        //!< After a long idle period every bin of the window holds the same constant occupancy
+        if (now - m_binStart >= TimeStep(m_binWidth.GetTimeStep() * (m_numBins + 1))) {
+            double full_bin = m_current * m_binWidth.GetSeconds();
+            std::fill(m_bins.begin(), m_bins.end(), full_bin);
+            m_windowIntegral = full_bin * m_numBins;
+            int64_t elapsed_bins = (now - m_binStart).GetTimeStep() / m_binWidth.GetTimeStep();
+            m_binStart = m_binStart + TimeStep(m_binWidth.GetTimeStep() * elapsed_bins);
+            m_lastChange = m_binStart;
+            m_currentIntegral = 0.0;
+            return;
+        }
+        while (now >= m_binStart + m_binWidth) {
+            Time bin_end = m_binStart + m_binWidth;
+            double closed = m_currentIntegral + m_current * (bin_end - m_lastChange).GetSeconds();
+            m_windowIntegral += closed - m_bins[m_nextBin];
+            m_bins[m_nextBin] = closed;
+            m_nextBin = (m_nextBin + 1) % m_numBins;
+            m_binStart = bin_end;
+            m_lastChange = bin_end;
+            m_currentIntegral = 0.0;
+        }
+    }
+
+    void
+    QueueOccupancyTracker::PacketsInQueueChanged (uint32_t oldValue, uint32_t newValue)
+    {
+        Time now = Simulator::Now();
+        Advance(now);
+        m_currentIntegral += m_current * (now - m_lastChange).GetSeconds();
+        m_lastChange = now;
+        m_current = newValue;
+    }
+
+    uint32_t
+    QueueOccupancyTracker::GetCurrentOccupancy () const
+    {
+        return m_current;
+    }
+
+    double
+    QueueOccupancyTracker::GetMeanOccupancy ()
+    {
+        Time now = Simulator::Now();
+        Advance(now);
+        double integral = m_windowIntegral + m_currentIntegral + m_current * (now - m_lastChange).GetSeconds();
+        //!< Before the first window is complete only the elapsed time is covered
+        double covered = std::min((m_binStart - m_start).GetSeconds(), m_binWidth.GetSeconds() * m_numBins)
+                + (now - m_binStart).GetSeconds();
+        if (covered <= 0.0) {
+            return m_current;
+        }
+        return integral / covered;
+    }
+
+}
@@ -0,0 +1,83 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#ifndef SATELLITE_NETWORK_QUEUE_OCCUPANCY_TRACKER_H
+#define SATELLITE_NETWORK_QUEUE_OCCUPANCY_TRACKER_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/queue.h"
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * Time-weighted occupancy of a device queue, maintained from the PacketsInQueue trace source.
+     *
+     * The occupancy integral is kept in a ring of bins covering a sliding window, so the mean
+     * and the current occupancy are O(1) reads and nothing is sampled on the forwarding path.
+     */
+    class QueueOccupancyTracker : public Object
+    {
+    public:
+        static TypeId GetTypeId (void);
+
+        /**
+         * @param queue     queue to follow
+         * @param window    length of the sliding window
+         * @param numBins   number of bins the window is divided into
+         */
+        QueueOccupancyTracker (Ptr<QueueBase> queue, Time window, uint32_t numBins);
+        ~QueueOccupancyTracker ();
+
+        /**
+         * Trace sink of QueueBase::PacketsInQueue.
+         */
+        void PacketsInQueueChanged (uint32_t oldValue, uint32_t newValue);
+
+        /**
+         * \returns number of packets currently in the queue
+         */
+        uint32_t GetCurrentOccupancy () const;
+
+        /**
+         * \returns time-weighted mean number of packets over the last window
+         */
+        double GetMeanOccupancy ();
+
+    private:
+        void Advance (Time now);
+        Time m_binWidth;
+        uint32_t m_numBins;
+        std::vector<double> m_bins;     //!< integral (packets x seconds) of the closed bins
+        uint32_t m_nextBin;             //!< ring slot the current bin is written to once closed
+        double m_windowIntegral;        //!< sum of m_bins
+        Time m_start;                   //!< time tracking started
+        Time m_binStart;                //!< start of the current bin
+        Time m_lastChange;              //!< last time the current bin integral was brought up to date
+        double m_currentIntegral;       //!< integral of the current bin until m_lastChange
+        uint32_t m_current;             //!< packets in queue
+    };
+
+}
+
+#endif //SATELLITE_NETWORK_QUEUE_OCCUPANCY_TRACKER_H
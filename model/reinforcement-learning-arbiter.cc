@@ -26,6 +26,7 @@
 #include "ns3/socket.h"
 #include "ns3/udp-socket.h"
 #include "ns3/packet.h"
+#include <limits>
 
  namespace ns3 {
 	NS_OBJECT_ENSURE_REGISTERED (ReinforcementLearningArbiter);
@@ -46,47 +47,38 @@
 		m_topology = satTopology;
         m_RLRoutingPort = 999;
         int num_of_ISL = 4;
-        int count =0; //to count the number of ISL links
+        int count =0; //to count the number of grid ISL links
         // Interface indices for all edges in-order
         const std::vector<std::pair<uint32_t, uint32_t>>& interface_idxs_for_undirected_edges = satTopology->GetInterfaceIdxsForUndirectedEdges();
 
-
-        int numSatellitesPerOrbit = m_topology->GetNumSatellitesPerOrbit();
-        int numOrbits = m_topology->GetNumOrbits();
+        //!< Single shell of the topology unless the helper registered the shells
+        m_constellation = m_topology->GetObject<ConstellationIndex>();
+        if (m_constellation == nullptr) {
+            m_constellation = CreateObject<ConstellationIndex>(std::vector<std::pair<uint32_t, uint32_t>>{
+                    {(uint32_t) m_topology->GetNumOrbits(), (uint32_t) m_topology->GetNumSatellitesPerOrbit()}});
+            m_topology->AggregateObject(m_constellation);
+        }
 
         m_neighborID = std::vector<uint32_t>(num_of_ISL, 0);//Four neighbor satellites from 0 to 3
         for (int i = 0; i < m_topology->GetNumUndirectedEdges(); i++) {
             std::pair<int64_t, int64_t> edge = m_topology->GetUndirectedEdges().at(i);
-            int32_t neighborId = m_node_id;
+            int32_t neighborId;
             if (edge.first == m_node_id) {
                 m_neighbor_node_id_to_if_idx.insert({edge.second,interface_idxs_for_undirected_edges.at(i).first});
                 neighborId = edge.second;
-                count ++;
-
             } else if (edge.second == m_node_id) {
                 m_neighbor_node_id_to_if_idx.insert({edge.first, interface_idxs_for_undirected_edges.at(i).second});
                 neighborId = edge.first;
-                count ++;
+            } else {
+                continue;
             }
-            int myOrbit = m_node_id / numSatellitesPerOrbit;
-            int neighborOrbit = neighborId / numSatellitesPerOrbit;
-
-            if (myOrbit==neighborOrbit) {
-
-                if (neighborId == m_node_id + 1 || (m_node_id % numSatellitesPerOrbit == numSatellitesPerOrbit - 1 && neighborId == m_node_id - numSatellitesPerOrbit + 1)) {
-                    m_neighborID.at(0) = neighborId;
-                } else if (neighborId == m_node_id - 1 || (m_node_id % numSatellitesPerOrbit == 0 && neighborId == m_node_id + numSatellitesPerOrbit - 1)) {
-                    m_neighborID.at(1) = neighborId;
-                }
+            //!< Cross-shell neighbors keep their interface but are not one of the four actions
+            int32_t direction = m_constellation->GetDirection(m_node_id, neighborId);
+            if (direction != ConstellationIndex::NOT_ADJACENT) {
+                m_neighborID.at(direction) = neighborId;
+                count ++;
             } else {
-
-                if (neighborId == m_node_id + numSatellitesPerOrbit ||
-                    (myOrbit == numOrbits - 1  && neighborOrbit == 0)) {
-                    m_neighborID.at(3) = neighborId;
-                } else if (neighborId == m_node_id - numSatellitesPerOrbit || (myOrbit ==0 && neighborOrbit == numOrbits - 1))
-                {
-                    m_neighborID.at(2) = neighborId;
-                }
+                m_cross_shell_neighborID.push_back(neighborId);
             }
         }
         // Save which interface is for which neighbor node id
@@ -95,7 +87,13 @@
                     "The satellites %d didn't record neighbor satellites interface correctly.", m_node_id
             ));
         }
-        m_uniform_random = CreateObject<UniformRandomVariable> ();
+        m_routing_random = PhiloxRandomStream(RandomStreamDomain::ROUTING, m_node_id);
+        //!< Shared table from the helper, or one that reads the topology on every lookup
+        m_attachments = m_topology->GetObject<TerminalAttachmentTable>();
+        if (m_attachments == nullptr) {
+            m_attachments = CreateObject<TerminalAttachmentTable>(m_topology, nodes, Seconds(0));
+            m_topology->AggregateObject(m_attachments);
+        }
 	}
 
 	ReinforcementLearningArbiter::~ReinforcementLearningArbiter(){    
@@ -113,26 +111,21 @@
 	{
         int32_t next_hop_node_id;
         uint32_t selected_if_idx;
-        uint32_t next_if_idx;
         int32_t source_sat_node_id;
         int32_t target_sat_node_id;
         bool end_to_end = true;
         //!<packets-to-end
-        if(m_topology->IsUserTerminalId(target_node_id)){
-            Ptr <Node> satellite_node_connect_to_target_ut = m_topology->GetUserTerminal(m_topology->NodeToUserTerminalId(target_node_id))
-                    ->GetSatelliteNode();
-            target_sat_node_id = satellite_node_connect_to_target_ut->GetId();
+        if(m_attachments->IsTerminal(target_node_id)){
+            target_sat_node_id = m_attachments->GetServingSatellite(target_node_id);
         }else
         {
             end_to_end = false;
             target_sat_node_id = target_node_id;
         }
         //!<packets-from-end
-        if(m_topology->IsUserTerminalId(source_node_id))
+        if(m_attachments->IsTerminal(source_node_id))
         {
-            Ptr <Node> satellite_node_connect_to_source_ut = m_topology->GetUserTerminal(m_topology->NodeToUserTerminalId(source_node_id))
-                    ->GetSatelliteNode();
-            source_sat_node_id = satellite_node_connect_to_source_ut->GetId();
+            source_sat_node_id = m_attachments->GetServingSatellite(source_node_id);
         }else
         {
             end_to_end = false;
@@ -143,11 +136,8 @@
         //!<Sending packets directly to ground equipment
         if(target_sat_node_id == m_node_id&&!(pkt->PeekPacketTag(broadcastTag))){
             //!<determining gateway and ip address
-            next_hop_node_id = target_node_id;
-            selected_if_idx = m_topology->GetServiceLinkNetDevices().Get(m_service_links_manager->GetServiceLinkDeviceId(target_node_id))->GetIfIndex();
-            next_if_idx = m_topology->GetServiceLinkNetDevices().Get(target_node_id-m_topology->GetNumSatellites()+m_topology->GetNumSatellites()*m_topology->GetCapacity())->GetIfIndex();
-            uint32_t select_ip_gateway = m_nodes.Get(next_hop_node_id)->GetObject<Ipv4>()->GetAddress(next_if_idx, 0).GetLocal().Get();
-            return ArbiterResult(false, selected_if_idx, select_ip_gateway); // Gateway is set to 0.0.0.0 as gateway does not matter for a point-to-point link
+            const TerminalAttachmentTable::Attachment &delivery = m_attachments->GetDelivery(target_node_id, m_service_links_manager);
+            return ArbiterResult(false, delivery.ifIndex, delivery.gateway);
         }
         //!<else, sending packets to neighboring satellite for relaying
         else{
@@ -183,15 +173,13 @@
     }
 
     int
-    ReinforcementLearningArbiter::GetActionFromProbability(std::vector<double> probability)
+    ReinforcementLearningArbiter::GetActionFromProbability(const std::vector<double> &probability)
     {
         NS_ASSERT(probability.size()==4);
         const int size = 4;
         int action = -1;
-        double random_value = m_uniform_random->GetValue (0.0, 1.0);
-        while(random_value==1.0){
-            random_value = m_uniform_random->GetValue (0.0, 1.0);
-        }
+        //!< in (0, 1), no need to redraw
+        double random_value = m_routing_random.GetUniform();
 
 
         double max_prob = -1.0;
@@ -242,13 +230,8 @@
     int
     ReinforcementLearningArbiter::CalculateRemainSteps(int sat1_Id,int sat2_Id)
     {
-        int orbit_index_1 = sat1_Id/m_topology->GetNumSatellitesPerOrbit();
-        int orbit_index_2 = sat2_Id/m_topology->GetNumSatellitesPerOrbit();
-        int hops_horizontal = std::min(std::abs(orbit_index_2-orbit_index_1), (int)m_topology->GetNumOrbits()-std::abs(orbit_index_2-orbit_index_1));
-        int phase_index_1 = sat1_Id % m_topology->GetNumSatellitesPerOrbit();
-        int phase_index_2 = sat2_Id % m_topology->GetNumSatellitesPerOrbit();
-        int hops_vertical = std::min(abs(phase_index_2-phase_index_1), (int)m_topology->GetNumSatellitesPerOrbit() - abs(phase_index_2-phase_index_1));
-        return hops_vertical+hops_horizontal;
+        uint32_t hops = m_constellation->GetHopDistance(sat1_Id, sat2_Id);
+        return hops == ConstellationIndex::UNREACHABLE ? std::numeric_limits<int>::max() : (int) hops;
     }
 
     Ptr<ServiceLinkManager>
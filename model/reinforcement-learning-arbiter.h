@@ -27,6 +27,9 @@
 #include "ns3/service-link-manager.h"
 #include "ns3/address.h"
 #include "ns3/socket.h"
+#include "philox-random-stream.h"
+#include "terminal-attachment-table.h"
+#include "constellation-index.h"
 
 namespace ns3 {
     class ServiceLinkManager;
@@ -75,8 +78,9 @@ namespace ns3 {
 
            void SetServiceManager(Ptr<ServiceLinkManager> serviceLinkManager);
            Ptr<ServiceLinkManager> GetServiceManager() const;
-           int CalculateRemainSteps(int sat1_Id,int sat2_Id);
-           int GetActionFromProbability(std::vector<double> probability);
+           //!< Hops between two satellites from the constellation geometry, arbiters holding link state refine it
+           virtual int CalculateRemainSteps(int sat1_Id,int sat2_Id);
+           int GetActionFromProbability(const std::vector<double> &probability);
            int GetInterfaceAtSameDirection (int interfaceID);
 
 
@@ -84,9 +88,12 @@ namespace ns3 {
       protected:
           Ptr<TopologySatellite> m_topology; //!<Store information of topology
           std::vector <uint32_t> m_neighborID; //!<Store four mappings <direction, neighbor id>, directions are north 0, south 1, west 2, east 3.
+          std::vector <uint32_t> m_cross_shell_neighborID;    //!< neighbors in other shells, not one of the four actions
           std::map <uint32_t, uint32_t> m_neighbor_node_id_to_if_idx;//!<Store four mappings <neighbor id,interface number to neighbor>
           Ptr<ServiceLinkManager> m_service_links_manager;    //!< service links manager
-          Ptr<UniformRandomVariable> m_uniform_random;
+          Ptr<ConstellationIndex> m_constellation;    //!< shell, orbit and phase of every satellite, shared through the topology
+          Ptr<TerminalAttachmentTable> m_attachments;    //!< serving satellite of every terminal, shared through the topology
+          PhiloxRandomStream m_routing_random; //!< Stream keyed by this satellite for sampling actions
           std::map<uint32_t, Ptr<Socket>> m_peersSockets;    //!< The sockets of neighbors
           uint32_t m_RLRoutingPort;
     };
@@ -21,6 +21,11 @@
 
 #include "reinforcement-learning-single-forward.h"
 #include "satellite-routing-tag.h"
+#include "constellation-tick-scheduler.h"
+#include "ns3/udp-header.h"
+#include "ns3/udp-l4-protocol.h"
+#include <cmath>
+#include <limits>
 #define eps 1e-12
 namespace ns3 {
 
@@ -44,21 +49,24 @@ namespace ns3 {
             NodeContainer nodes,
             Ptr<TopologySatellite> satTopology,
             Ptr<MultiAgentGymEnvRouting> agentGymEnv,
-            std::vector<std::vector<uint32_t>>  routing_table
-    ) : ReinforcementLearningArbiter(this_node, nodes, satTopology)
+            Ptr<ShortestPathTable> shortestPaths
+    ) : ReinforcementLearningArbiter(this_node, nodes, satTopology),
+        m_reward(AccountedAllocator<RewardMap::value_type>(&m_memory, MemoryCategory::DYNAMIC_ROUTES)),
+        m_count(AccountedAllocator<CountMap::value_type>(&m_memory, MemoryCategory::DYNAMIC_ROUTES)),
+        m_action(AccountedAllocator<DynamicRouteMap::value_type>(&m_memory, MemoryCategory::DYNAMIC_ROUTES)),
+        m_action_expiry(AccountedAllocator<RouteExpiryQueue::value_type>(&m_memory, MemoryCategory::DYNAMIC_ROUTES)),
+        m_packet_action(AccountedAllocator<PacketActionMap::value_type>(&m_memory, MemoryCategory::PENDING_ACTIONS)),
+        m_pending_queries(AccountedAllocator<PendingQuerySet::value_type>(&m_memory, MemoryCategory::PENDING_ACTIONS))
     {
         //!<ns-3gym environment
         m_agentGymEnv = agentGymEnv;
         //!<Period of sending link states to neighbors
         m_period_gather_neighbors = satTopology->GetPeriodInformationGathering();
         //!<Information from neighbors
-        m_information_neighbors = std::vector<double>(56, 0.0);
-        m_information_neighbors_1 = std::vector<double>(56, 0.0);
-        m_information_neighbors_2 = std::vector<double>(56, 0.0);
-        m_information_neighbors_3 = std::vector<double>(56, 0.0);
-        m_information_neighbors_0 = std::vector<double>(56, 0.0);
+        m_observation = std::vector<float>(OBSERVATION_SIZE, 0.0f);
+        m_observation_time = Seconds(-1);
         //!<Static Routing
-        m_routing_table = routing_table;
+        m_shortest_paths = shortestPaths;
         //!<routing type
         m_rotingType = satTopology->GetRoutingType();
         m_neighbor_ISL_state = {ISLState::WORK,ISLState::WORK,ISLState::WORK,ISLState::WORK};
@@ -67,20 +75,48 @@ namespace ns3 {
         m_actual_mask = {0,0,0,0};
         m_send_vector = {0,0,0,0,0};
         m_receive_vector = {0,0,0,0,0};
-        m_mean_queue_length = {0.0,0.0,0.0,0.0};
-        m_count_for_queue_length = 0.0;
+        m_flowlet_gap = Seconds(0);
+        m_flowlet_hits = 0;
+        m_flowlet_misses = 0;
+        m_flowlet_sweep_at = 4096;
+        m_link_state_check_period = Seconds(GetGatherPeriod()/2.0);
+        m_link_state_adaptive = false;
+        m_idle_ratio_threshold = 0.0;
+        m_data_rate_threshold = 0.0;
+        m_link_state_max_silence = m_link_state_check_period;
+        m_last_link_state = std::vector<float>(FEATURE_SIZE, 0.0f);
+        m_last_link_state_ISL = m_neighbor_ISL_state;
+        m_last_link_state_time = Seconds(0);
+        m_link_state_sent = 0;
+        m_link_state_suppressed = 0;
         m_times_of_using_RL = 0;
+        m_num_decisions = 0;
         m_num_masks = 0;
+        m_busyness = {0.0,0.0,0.0,0.0};
+        m_action_generation = 0;
+        m_async_query = false;
+        m_async_query_delay = Seconds(0);
+        m_async_fallback = PolicyFallback::STALE;
+        m_route_ttl_jitter = 0.0;
+        m_route_prefetch_lead = Seconds(0);
+        m_route_expiry_random = PhiloxRandomStream(RandomStreamDomain::ROUTE_EXPIRY, m_node_id);
+        m_route_prefetches = 0;
         uint32_t first_device_Id_to_neighbor = m_neighbor_node_id_to_if_idx[m_neighborID.at(0)];
         Ptr<LaserNetDevice> first_device_to_neighbor = m_topology->GetNodes().Get(m_node_id)->GetDevice(first_device_Id_to_neighbor)->GetObject<LaserNetDevice>();
         m_max_queue_size = first_device_to_neighbor->GetQueue()->GetMaxSize().GetValue();
         m_disconnection = false;
         Simulator::Schedule(Seconds(0.0),&ReinforcementSingleForward::BuildSockets,this);
-        Simulator::Schedule(MilliSeconds(1.0),&ReinforcementSingleForward::BroadCastLinkState,this);
+        //!< Fixed size parts, the containers count themselves
+        MemoryAccounting::Add(MemoryCategory::OBJECTS, sizeof(ReinforcementSingleForward), &m_memory);
+        MemoryAccounting::Add(MemoryCategory::LINK_STATE, OBSERVATION_SIZE * sizeof(float) +
+                (GraphObservation::NUM_NODES * GraphObservation::DIM_NODE_FEATURE +
+                 GraphObservation::NUM_EDGES * GraphObservation::DIM_EDGE_FEATURE) * sizeof(float), &m_memory);
     }
 
     ReinforcementSingleForward::~ReinforcementSingleForward() {
-        // Left empty intentionally
+        for (MemoryCategory category : {MemoryCategory::OBJECTS, MemoryCategory::LINK_STATE, MemoryCategory::QUEUE_TRACKING}) {
+            MemoryAccounting::Add(category, -m_memory.GetCurrent(category), &m_memory);
+        }
     }
 
     void
@@ -91,9 +127,16 @@ namespace ns3 {
             Ptr<Node> neighborNode = m_topology->GetSatelliteNodes().Get(m_neighborID.at(i));
             Ptr<ReinforcementSingleForward> reinforceSingleForward = neighborNode->GetObject<Ipv4>()->GetRoutingProtocol()->GetObject<Ipv4ArbiterRouting>()->GetArbiter()->GetObject<ReinforcementSingleForward>();
             m_singleForward_neighbors.push_back(reinforceSingleForward);
+            std::vector<uint32_t> neighbors_of_neighbor = reinforceSingleForward->GetNeighborSatellites();
+            std::vector<uint32_t>::iterator it = find(neighbors_of_neighbor.begin(), neighbors_of_neighbor.end(), (uint32_t) m_node_id);
+            NS_ASSERT(it != neighbors_of_neighbor.end());
+            m_direction_at_neighbor.push_back(it - neighbors_of_neighbor.begin());
+            m_mobility_neighbors.push_back(neighborNode->GetObject<MobilityModel>());
             uint32_t the_device_Id_to_neighbor = m_neighbor_node_id_to_if_idx[m_neighborID.at(i)];
             Ptr<LaserNetDevice> the_device_to_neighbor = m_topology->GetSatelliteNodes().Get(m_node_id)->GetDevice(the_device_Id_to_neighbor)->GetObject<LaserNetDevice>();
             m_laserDevice_neighbors.push_back(the_device_to_neighbor);
+            m_queue_trackers.push_back(CreateObject<QueueOccupancyTracker>(the_device_to_neighbor->GetQueue(), Seconds(1.0), 10));
+            MemoryAccounting::Add(MemoryCategory::QUEUE_TRACKING, sizeof(QueueOccupancyTracker) + 10 * sizeof(double), &m_memory);
         }
         m_capacity = m_topology->GetCapacity();
         for (uint32_t i = 0; i < m_capacity; ++i) {
@@ -102,22 +145,39 @@ namespace ns3 {
             NS_ASSERT(SLDevice_nodeId == m_node_id);
             m_service_linkDevices.push_back(SLDevice);
         }
+        for (uint32_t neighborId : m_cross_shell_neighborID) {
+            m_laserDevice_cross_shell.push_back(m_topology->GetSatelliteNodes().Get(m_node_id)
+                    ->GetDevice(m_neighbor_node_id_to_if_idx[neighborId])->GetObject<LaserNetDevice>());
+        }
         NS_ASSERT(m_singleForward_neighbors.size()==4);
         NS_ASSERT(m_laserDevice_neighbors.size()==4);
         NS_ASSERT(m_service_linkDevices.size()==m_capacity);
+        m_mobility = m_topology->GetSatelliteNodes().Get(m_node_id)->GetObject<MobilityModel>();
+        m_fluid_traffic = m_topology->GetObject<FluidTrafficModel>();
+        if (m_fluid_traffic != nullptr) {
+            for (uint32_t i = 0; i < 4; ++i) {
+                m_fluid_traffic->SetLinkDevice(m_node_id, i, m_laserDevice_neighbors[i]);
+            }
+        }
+        m_link_geometry = m_topology->GetObject<LinkGeometryTable>();
+        if (m_link_geometry != nullptr) {
+            for (int i = 0; i < 4; ++i) {
+                m_neighbor_links.push_back(m_link_geometry->GetLinkIndex(m_node_id, m_neighborID.at(i)));
+                NS_ASSERT(m_neighbor_links.back() != LinkGeometryTable::NOT_A_LINK);
+            }
+        }
+        UpdateChannelFeatures();
         UpdatingPacketCount();
-        Simulator::Schedule(Seconds(1.0),&ReinforcementSingleForward::ReSetQueueLength,this);
-    }
-
-
-    void
-    ReinforcementSingleForward::ReSetQueueLength()
-    {
-        for (int i = 0; i < 4; ++i) {
-            m_mean_queue_length.at(i) = 0.0;
+        Ptr<ConstellationTickScheduler> ticks = ConstellationTickScheduler::Get();
+        ticks->Subscribe(ticks->GetTaskClass("BroadCastLinkState", MilliSeconds(1.0), m_link_state_check_period),
+                         MakeCallback(&ReinforcementSingleForward::BroadCastLinkState, this));
+        if (m_route_prefetch_lead.IsStrictlyPositive()) {
+            ticks->Subscribe(ticks->GetTaskClass("PrefetchDynamicRoutes", m_route_prefetch_lead, m_route_prefetch_lead),
+                             MakeCallback(&ReinforcementSingleForward::PrefetchDynamicRoutes, this));
         }
-        m_count_for_queue_length = 0.0;
-        Simulator::Schedule(Seconds(1.0),&ReinforcementSingleForward::ReSetQueueLength,this);
+        ticks->Subscribe(ticks->GetTaskClass("UpdatingPacketCount", Seconds(1.0), Seconds(1.0)),
+                         MakeCallback(&ReinforcementSingleForward::CountPackets, this),
+                         MakeCallback(&ReinforcementSingleForward::PublishServiceLinkCount, this));
     }
 
     bool
@@ -165,6 +225,7 @@ namespace ns3 {
     void
     ReinforcementSingleForward::RLDecisionMaking(std::vector <uint32_t> PriorityActions, std::vector <uint32_t> AlternateActions) {
         NS_LOG_FUNCTION(this);
+        m_num_decisions++;
         m_feasible_actions = 0;
         m_next_hop = -1;
         m_approach = false;
@@ -172,14 +233,14 @@ namespace ns3 {
         m_final_mask = {0, 0, 0, 0};
         m_wait_reward = false;
         m_drop = false;
-        //!< read queue length for decision and calculating average queue length
+        //!< read queue length for decision, the occupancy is maintained by the queue traces
         for (uint32_t i = 0; i < 4; i++) {
-            uint32_t queue_size = m_laserDevice_neighbors[i]->GetQueue()->GetCurrentSize().GetValue();
             m_neighbor_ISL_state.at(i) = m_laserDevice_neighbors[i]->GetDeviceState();
-            m_mean_queue_length.at(i) += (double) (queue_size) / (double) (GetMaxQueueLength());
-            m_neighbor_queue_size.at(i) = queue_size;
+            m_neighbor_queue_size.at(i) = m_queue_trackers[i]->GetCurrentOccupancy();
+            if (m_fluid_traffic != nullptr) {
+                m_neighbor_queue_size.at(i) += (uint32_t) std::lround(m_fluid_traffic->GetQueueEstimate(m_node_id, i));
+            }
         }
-        m_count_for_queue_length += 1.0;
 
         if(!StrategyWithDisconnection(PriorityActions,AlternateActions))
         {
@@ -225,57 +286,23 @@ namespace ns3 {
         string_mask = oss.str();
         m_action_iter = m_action.find(string_mask);
         //!<If the action is found and the action is still valid:
-        if (m_action_iter != m_action.end() && Simulator::Now() -
-                std::get<1>(m_action_iter->second) < Seconds(GetGatherPeriod())) {
+        if (m_action_iter != m_action.end() && Simulator::Now() < std::get<1>(m_action_iter->second)) {
             //!<find next hop directly.
             m_next_hop = GetActionFromProbability(std::get<0>(m_action_iter->second));
-        } else {
-            //!<If no action is found, create a new map of the reward and action
-            if (m_action_iter == m_action.end()) {
-                m_reward.insert(std::pair<std::string, double>(string_mask, 0.0));
-                m_count.insert(std::pair<std::string, uint32_t>(string_mask, 0));
-                //!< Return the state and reward to python
-                GetGymEnvRouting()->ObserveNow(m_node_id, 0.0, m_neighborID, m_final_mask);
-                //!< get next hop
-                std::vector<double> action_probability = GetGymEnvRouting()->GetNewProbability();
-                m_next_hop = GetActionFromProbability(action_probability);
-                //!< create a new map of <mask, <action,time>>
-                m_action.insert(std::pair < std::string, std::tuple < std::vector < double > ,
-                                Time >> (string_mask, std::make_tuple(action_probability, Simulator::Now())));
-                m_times_of_using_RL++;
-                m_num_masks++;
-            } else {
-                //!< Dynamic routing entry is expired.
-                m_reward_iter = m_reward.find(string_mask);
-                NS_ASSERT(m_reward_iter != m_reward.end());
-                m_count_iter = m_count.find(string_mask);
-                NS_ASSERT(m_count_iter != m_count.end());
-                double Reward = m_reward_iter->second;
-                //!< Prevents divisor from being 0
-                if (m_count_iter->second >= 1) {
-                    Reward = Reward / (double) (m_count_iter->second);
-                }
-                //!< Return the state and reward to agent
-                //!< Call the policy network.
-                GetGymEnvRouting()->ObserveNow(m_node_id, Reward, m_neighborID, m_final_mask);
-                //!< get next hop
-                std::vector<double> action_probability = GetGymEnvRouting()->GetNewProbability();
-                m_next_hop = GetActionFromProbability(action_probability);
-                //!< Set the reward to 0 and prepare to count the reward in the next time period.
-                m_reward_iter->second = 0.0;
-                m_count_iter->second = 0;
-                //!< erase packet reward tracer
-                for (m_packet_action_iter = m_packet_action.begin(); m_packet_action_iter != m_packet_action.end();) {
-                    if (m_packet_action_iter->second == string_mask) {
-                        m_packet_action_iter = m_packet_action.erase(m_packet_action_iter);
-                    } else {
-                        ++m_packet_action_iter;
-                    }
-                }
-                //!< set new entry with  <action_mask <action, time>> pair
-                m_action_iter->second = std::make_tuple(action_probability, Simulator::Now());
-                m_times_of_using_RL++;
+            std::get<3>(m_action_iter->second) = true;
+        } else if (m_async_query) {
+            //!< Rewards of packets forwarded meanwhile are counted for the coming query
+            m_reward.insert(std::pair<std::string, double>(string_mask, 0.0));
+            m_count.insert(std::pair<std::string, uint32_t>(string_mask, 0));
+            m_next_hop = GetFallbackAction(string_mask);
+            //!< One outstanding query per mask, answered at a fixed simulation delay
+            if (m_pending_queries.insert(string_mask).second) {
+                Simulator::Schedule(m_async_query_delay, &ReinforcementSingleForward::QueryPolicyAsync, this,
+                                    string_mask, m_final_mask);
             }
+        } else {
+            m_next_hop = QueryPolicy(string_mask, m_final_mask);
+            std::get<3>(m_action[string_mask]) = true;
         }
         NS_ASSERT(m_next_hop >= 0 && m_next_hop <= 3);
         m_approach = PriorityActions.at(m_next_hop)==1 ? true:false;
@@ -283,6 +310,135 @@ namespace ns3 {
         return;
     }
 
+    int
+    ReinforcementSingleForward::QueryPolicy(const std::string &mask, std::vector<uint32_t> finalMask)
+    {
+        double Reward = 0.0;
+        m_action_iter = m_action.find(mask);
+        if (m_action_iter == m_action.end()) {
+            //!<If no action is found, create a new map of the reward and action
+            m_reward.insert(std::pair<std::string, double>(mask, 0.0));
+            m_count.insert(std::pair<std::string, uint32_t>(mask, 0));
+            m_num_masks++;
+        }
+        //!< Dynamic routing entry is expired, return the mean reward of the last period.
+        m_reward_iter = m_reward.find(mask);
+        NS_ASSERT(m_reward_iter != m_reward.end());
+        m_count_iter = m_count.find(mask);
+        NS_ASSERT(m_count_iter != m_count.end());
+        if (m_action_iter != m_action.end()) {
+            Reward = m_reward_iter->second;
+            //!< Prevents divisor from being 0
+            if (m_count_iter->second >= 1) {
+                Reward = Reward / (double) (m_count_iter->second);
+            }
+        }
+        //!< Return the state and reward to agent
+        //!< Call the policy network.
+        GetGymEnvRouting()->ObserveNow(m_node_id, Reward, m_neighborID, finalMask);
+        //!< get next hop
+        std::vector<double> action_probability = GetGymEnvRouting()->GetNewProbability();
+        int action = GetActionFromProbability(action_probability);
+        RecordExperience(Reward, finalMask, action, action_probability);
+        //!< Set the reward to 0 and prepare to count the reward in the next time period.
+        m_reward_iter->second = 0.0;
+        m_count_iter->second = 0;
+        //!< erase packet reward tracer
+        for (m_packet_action_iter = m_packet_action.begin(); m_packet_action_iter != m_packet_action.end();) {
+            if (m_packet_action_iter->second == mask) {
+                m_packet_action_iter = m_packet_action.erase(m_packet_action_iter);
+            } else {
+                ++m_packet_action_iter;
+            }
+        }
+        //!< set new entry with  <action_mask <action, time>> pair
+        InstallDynamicRoute(mask, action_probability);
+        m_times_of_using_RL++;
+        return action;
+    }
+
+    void
+    ReinforcementSingleForward::QueryPolicyAsync(std::string mask, std::vector<uint32_t> finalMask)
+    {
+        m_pending_queries.erase(mask);
+        QueryPolicy(mask, finalMask);
+    }
+
+    int
+    ReinforcementSingleForward::GetFallbackAction(const std::string &mask)
+    {
+        //!< Keep using the expired vector of this mask while its query is outstanding
+        if (m_async_fallback == PolicyFallback::STALE) {
+            m_action_iter = m_action.find(mask);
+            if (m_action_iter != m_action.end()) {
+                return GetActionFromProbability(std::get<0>(m_action_iter->second));
+            }
+        }
+        if (m_async_fallback == PolicyFallback::UNIFORM) {
+            std::vector<double> probability(4, 0.0);
+            for (int i = 0; i < 4; ++i) {
+                probability.at(i) = m_actual_mask.at(i) == 1 ? 1.0 / (double) m_feasible_actions : 0.0;
+            }
+            return GetActionFromProbability(probability);
+        }
+        //!< Shortest queue among feasible actions, ties go to actions closer to target
+        int action = -1;
+        for (int i = 0; i < 4; ++i) {
+            if (m_actual_mask.at(i) != 1) {
+                continue;
+            }
+            if (action == -1 || m_neighbor_queue_size.at(i) < m_neighbor_queue_size.at(action) ||
+                (m_neighbor_queue_size.at(i) == m_neighbor_queue_size.at(action) &&
+                 m_final_mask.at(i) > m_final_mask.at(action))) {
+                action = i;
+            }
+        }
+        NS_ASSERT(action != -1);
+        return action;
+    }
+
+    void
+    ReinforcementSingleForward::SetAsyncPolicyQuery(bool enable, Time delay, std::string fallback)
+    {
+        m_async_query = enable;
+        m_async_query_delay = delay;
+        if (fallback == "stale") {
+            m_async_fallback = PolicyFallback::STALE;
+        } else if (fallback == "uniform") {
+            m_async_fallback = PolicyFallback::UNIFORM;
+        } else if (fallback == "queue") {
+            m_async_fallback = PolicyFallback::QUEUE;
+        } else {
+            throw std::runtime_error(format_string(
+                    "Unknown policy query fallback: %s (stale, uniform or queue).", fallback.c_str()
+            ));
+        }
+    }
+
+    void
+    ReinforcementSingleForward::SetDynamicRouteRefresh(double ttlJitter, Time prefetchLead)
+    {
+        if (ttlJitter < 0.0 || ttlJitter >= 1.0) {
+            throw std::runtime_error(format_string(
+                    "Dynamic route TTL jitter must be in [0, 1): %f.", ttlJitter
+            ));
+        }
+        m_route_ttl_jitter = ttlJitter;
+        m_route_prefetch_lead = prefetchLead;
+    }
+
+    uint64_t
+    ReinforcementSingleForward::GetNumPrefetchedRoutes() const
+    {
+        return m_route_prefetches;
+    }
+
+    Ptr<ShortestPathTable>
+    ReinforcementSingleForward::GetShortestPathTable() const
+    {
+        return m_shortest_paths;
+    }
+
     int32_t
     ReinforcementSingleForward::TopologySatelliteDecide(
             int32_t source_node_id,
@@ -296,11 +452,31 @@ namespace ns3 {
 
         NS_LOG_FUNCTION (this);
         NS_ASSERT(m_topology->IsSatelliteId(source_node_id)&&m_topology->IsSatelliteId(target_node_id));
+        uint8_t next_hop_mask = m_shortest_paths->GetNextHopMask(m_node_id, target_node_id);
         if(read_static_route_directly){
-             return m_routing_table.at(target_node_id).at(0);
+            //!< First shortest next hop in slot order: north, south, west, east, then cross-shell links.
+            //!< Equal-cost ties no longer follow the first entry of the topology routing list (CalculateStaticRoute
+            //!< is not run anymore), so static-routed packets may take another path of the same hop count.
+            for (uint32_t i = 0; i < ShortestPathTable::MAX_DEGREE; ++i) {
+                if ((next_hop_mask >> i) & 1) {
+                    if (m_path_tracer != nullptr && m_path_tracer->IsSampled(pkt->GetUid())) {
+                        m_path_tracer->RecordHop(ipHeader.GetSource().Get(), ipHeader.GetDestination().Get(), pkt->GetUid(),
+                                                 m_node_id, PathDecisionKind::STATIC, i);
+                    }
+                    return m_shortest_paths->GetNeighbor(m_node_id, i);
+                }
+            }
+            throw std::runtime_error(format_string(
+                    "The satellite %d has no route to satellite %d.", m_node_id, target_node_id
+            ));
         }
+        //!< The tag is peeked once per hop and reused for the update below
         SatelliteRoutingTag routingTag;
-        NS_ASSERT(pkt->PeekPacketTag(routingTag));
+        if(!pkt->PeekPacketTag(routingTag)){
+            throw std::runtime_error(format_string(
+                    "The satellite %d received a packet without routing tag.", m_node_id
+            ));
+        }
         int loop_action =-1;
         //!<From which neighbor.
         uint32_t neighbor_id = routingTag.GetLastNodeID();
@@ -309,9 +485,59 @@ namespace ns3 {
         //!< If the last hop is ground equipment then do not consider
         if(!m_topology->IsUserTerminalId(neighbor_id)){
             std::vector<uint32_t>::iterator it=find(m_neighborID.begin(),m_neighborID.end(),neighbor_id);
-            NS_ASSERT(it!=m_neighborID.end());
             //!<Remember that blocking this neighbor cause packets cannot generate loops.
-            loop_action = it - m_neighborID.begin();
+            //!< A packet from another shell came over a link that is not one of the four actions
+            if (it != m_neighborID.end()) {
+                loop_action = it - m_neighborID.begin();
+            } else {
+                NS_ASSERT(std::find(m_cross_shell_neighborID.begin(), m_cross_shell_neighborID.end(), neighbor_id) != m_cross_shell_neighborID.end());
+            }
+        }
+
+        //!< Only cross-shell ISLs lead towards the target, take the first of them
+        if ((next_hop_mask & 0x0F) == 0 && next_hop_mask != 0) {
+            uint32_t slot = __builtin_ctz(next_hop_mask);
+            if (m_path_tracer != nullptr && m_path_tracer->IsSampled(pkt->GetUid())) {
+                m_path_tracer->RecordHop(ipHeader.GetSource().Get(), ipHeader.GetDestination().Get(), pkt->GetUid(),
+                                         m_node_id, PathDecisionKind::STATIC, slot);
+            }
+            return ForwardOnCrossShellLink(routingTag, slot - 4);
+        }
+
+        //!< Same flowlet: reuse its next hop while it is not back where the packet came from and its ISL works
+        FlowletKey flowletKey = {};
+        if (m_flowlet_gap.IsStrictlyPositive()) {
+            flowletKey = GetFlowletKey(pkt, ipHeader, target_node_id);
+            std::unordered_map<FlowletKey, Flowlet, FlowletKeyHash>::iterator flowlet = m_flowlets.find(flowletKey);
+            if (flowlet != m_flowlets.end() && Simulator::Now() - flowlet->second.lastSeen < m_flowlet_gap &&
+                flowlet->second.nextHop != loop_action &&
+                m_laserDevice_neighbors[flowlet->second.nextHop]->GetDeviceState() == ISLState::WORK) {
+                int nextHop = flowlet->second.nextHop;
+                uint32_t queueSize = m_queue_trackers[nextHop]->GetCurrentOccupancy();
+                if (m_fluid_traffic != nullptr) {
+                    queueSize += (uint32_t) std::lround(m_fluid_traffic->GetQueueEstimate(m_node_id, nextHop));
+                }
+                //!< A hop whose queue is full is decided again rather than reused as a drop
+                if (queueSize + 1 < GetMaxQueueLength()) {
+                    m_flowlet_hits++;
+                    m_num_decisions++;
+                    flowlet->second.lastSeen = Simulator::Now();
+                    //!< A reused policy decision is rewarded like the query it came from
+                    if (!flowlet->second.mask.empty()) {
+                        WaitForReward(routingTag, pkt, target_node_id, flowlet->second.mask);
+                    }
+                    //!< Labelled from the current mask, a link repair may have changed it since the flowlet began
+                    bool approach = (next_hop_mask >> nextHop) & 1;
+                    UpdatingRoutingTagReturnReward(routingTag, approach ? resultLastDecision::ApproachingTarget
+                                                                        : resultLastDecision::AwayFromTarget, nextHop);
+                    if (m_path_tracer != nullptr && m_path_tracer->IsSampled(pkt->GetUid())) {
+                        m_path_tracer->RecordHop(ipHeader.GetSource().Get(), ipHeader.GetDestination().Get(), pkt->GetUid(),
+                                                 m_node_id, approach ? PathDecisionKind::APPROACH : PathDecisionKind::AWAY, nextHop);
+                    }
+                    return m_neighborID.at(nextHop);
+                }
+            }
+            m_flowlet_misses++;
         }
 
         //!<Create two sets of mask, one that can approach the target node and one cannot
@@ -319,11 +545,8 @@ namespace ns3 {
         std::vector <uint32_t> mask_approach ={0,0,0,0};
         std::vector <uint32_t> mask_away ={0,0,0,0};
         //!<Identify behaviors that can approach the target by looking up the static routing table
-        size_t size = m_routing_table.at(target_node_id).size();
-        for (size_t i = 0; i < size; ++i) {
-            std::vector<uint32_t>::iterator it=find(m_neighborID.begin(),m_neighborID.end(),m_routing_table.at(target_node_id).at(i));
-            NS_ASSERT(it!=m_neighborID.end());
-            mask_approach.at(it-m_neighborID.begin()) = 1;
+        for (int i = 0; i < 4; ++i) {
+            mask_approach.at(i) = (next_hop_mask >> i) & 1;
         }
 
         NS_ASSERT(mask_approach.size()==4);
@@ -349,15 +572,12 @@ namespace ns3 {
 
         //!<Agent needs to track every action， mask and reward
         RLDecisionMaking(mask_approach, mask_away);
-        BroadcastTag broadcastTag;
-        //!< wait for feedback of reward
-        if(GetGymEnvRouting()->Training()&&!(pkt->PeekPacketTag(broadcastTag)) && m_wait_reward && CalculateRemainSteps(m_node_id, target_node_id) >= 2){
-            std::string string_mask;
+        std::string string_mask;
+        if (m_wait_reward) {
             std::ostringstream oss;
             std::copy(m_final_mask.begin(), m_final_mask.end(), std::ostream_iterator<int>(oss));
             string_mask = oss.str();
-            //!< Record the packet and wait for the feedback of reward
-            m_packet_action.insert(std::pair<uint32_t, std::string>(routingTag.GetId(), string_mask));
+            WaitForReward(routingTag, pkt, target_node_id, string_mask);
         }
 
 
@@ -370,7 +590,30 @@ namespace ns3 {
             else
                 result = resultLastDecision::AwayFromTarget;
         }
-        UpdatingRoutingTagReturnReward(pkt,result,m_next_hop);
+        UpdatingRoutingTagReturnReward(routingTag,result,m_next_hop);
+        if (m_flowlet_gap.IsStrictlyPositive()) {
+            //!< Bound the cache by dropping closed flowlets once it grows, the next sweep waits until the
+            //!< survivors have doubled so that the scan stays amortized O(1) per packet
+            if (m_flowlets.size() >= m_flowlet_sweep_at) {
+                for (std::unordered_map<FlowletKey, Flowlet, FlowletKeyHash>::iterator it = m_flowlets.begin(); it != m_flowlets.end();) {
+                    it = Simulator::Now() - it->second.lastSeen >= m_flowlet_gap ? m_flowlets.erase(it) : std::next(it);
+                }
+                m_flowlet_sweep_at = std::max((size_t) 4096, 2 * m_flowlets.size());
+            }
+            //!< A dropped packet does not start or continue a flowlet
+            if (m_drop) {
+                m_flowlets.erase(flowletKey);
+            } else {
+                m_flowlets[flowletKey] = Flowlet{Simulator::Now(), m_next_hop, string_mask};
+            }
+        }
+        if (m_path_tracer != nullptr && m_path_tracer->IsSampled(pkt->GetUid())) {
+            PathDecisionKind kind = m_drop ? PathDecisionKind::DROP
+                    : m_wait_reward ? PathDecisionKind::RL_CHOSEN
+                    : m_approach ? PathDecisionKind::APPROACH : PathDecisionKind::AWAY;
+            m_path_tracer->RecordHop(ipHeader.GetSource().Get(), ipHeader.GetDestination().Get(), pkt->GetUid(),
+                                     m_node_id, kind, m_next_hop);
+        }
         uint32_t next_satellite = m_neighborID.at(m_next_hop);
         return next_satellite;
     }
@@ -378,11 +621,9 @@ namespace ns3 {
 
     void
     ReinforcementSingleForward::UpdatingRoutingTagReturnReward
-            (ns3::Ptr<const ns3::Packet> pkt,
+            (SatelliteRoutingTag &routingTag,
              resultLastDecision result, uint32_t nextSatellite)
     {
-        SatelliteRoutingTag routingTag;
-        NS_ASSERT(pkt->PeekPacketTag(routingTag));
         //In order to return a reward for two steps we need to do a reading,
         //if this is time interval has been recorded in the tag, then a two-step reward
         //will be returned to the satellite counting backwards two steps
@@ -489,6 +730,27 @@ namespace ns3 {
     }
 
 
+    uint32_t
+    ReinforcementSingleForward::ForwardOnCrossShellLink(SatelliteRoutingTag &routingTag, uint32_t index)
+    {
+        NS_ASSERT(index < m_cross_shell_neighborID.size());
+        routingTag.SetSteps(routingTag.GetSteps()+1);
+        routingTag.SetTimeStamp ((uint32_t)Simulator::Now().GetMicroSeconds());
+        routingTag.SetLastNodeID(m_node_id);
+        m_laserDevice_cross_shell.at(index)->SetRoutingTag(routingTag);
+        return m_cross_shell_neighborID.at(index);
+    }
+
+    void
+    ReinforcementSingleForward::WaitForReward(const SatelliteRoutingTag &routingTag, Ptr<const Packet> pkt, int32_t target_node_id,
+                                              const std::string &mask)
+    {
+        BroadcastTag broadcastTag;
+        if (GetGymEnvRouting()->Training() && CalculateRemainSteps(m_node_id, target_node_id) >= 2 && !(pkt->PeekPacketTag(broadcastTag))) {
+            m_packet_action.insert(std::pair<uint32_t, std::string>(routingTag.GetId(), mask));
+        }
+    }
+
     void
     ReinforcementSingleForward::ReceiveReward(uint32_t packet_Id, uint32_t time_interval_1, uint32_t time_interval_2,uint32_t channel_quality_1, uint32_t channel_quality_2 ,resultLastDecision result)
     {
@@ -554,6 +816,13 @@ namespace ns3 {
 
     void
     ReinforcementSingleForward::UpdatingPacketCount()
+    {
+        CountPackets();
+        PublishServiceLinkCount();
+    }
+
+    void
+    ReinforcementSingleForward::CountPackets()
     {
         for (int i = 0; i < 4; ++i) {
             std::vector<uint32_t> new_count = m_laserDevice_neighbors[i]->GetTotalPacketCount();
@@ -570,7 +839,21 @@ namespace ns3 {
         }
         m_receive_vector[4] = received_count_SL - m_receive_vector[4];
         m_send_vector[4] = sent_count_SL - m_send_vector[4];
-        Simulator::Schedule(Seconds(1.0), &ReinforcementSingleForward::UpdatingPacketCount,this);
+        //!< write packet counters into link state
+        for (int i = 0; i < 4; ++i) {
+            m_observation[FEATURE_ISL_SENT + i] = m_send_vector[i];
+            m_observation[FEATURE_ISL_RECEIVED + i] = m_receive_vector[i];
+        }
+        m_observation[FEATURE_SL_SENT] = m_send_vector[4];
+        m_observation[FEATURE_SL_RECEIVED] = m_receive_vector[4];
+    }
+
+    void
+    ReinforcementSingleForward::PublishServiceLinkCount()
+    {
+        for (int i = 0; i < 4; ++i) {
+            m_singleForward_neighbors[i]->SetNeighborServiceLinkCount(m_direction_at_neighbor[i], m_send_vector[4], m_receive_vector[4]);
+        }
     }
 
 
@@ -586,110 +869,174 @@ namespace ns3 {
         m_disconnection = disconnection;
     }
 
+    void
+    ReinforcementSingleForward::SetNeighborServiceLinkCount(uint32_t direction, uint32_t sent, uint32_t received)
+    {
+        NS_ASSERT(direction < 4);
+        m_observation[FEATURE_SL_SENT + 1 + direction] = sent;
+        m_observation[FEATURE_SL_RECEIVED + 1 + direction] = received;
+    }
+
+    void
+    ReinforcementSingleForward::UpdateChannelFeatures()
+    {
+        for (int i = 0; i < 4 ; ++i) {
+            if(m_laserDevice_neighbors[i]->GetDeviceState() == ISLState::SHUTDOWN)
+                m_observation[FEATURE_DATA_RATE + i] = 0.0;
+            else
+                m_observation[FEATURE_DATA_RATE + i] = (double)(m_laserDevice_neighbors[i]->GetDataRate().GetBitRate())/10000000.0;
+            m_observation[FEATURE_CHANNEL_QUALITY + i] = m_laserDevice_neighbors[i]->GetDataRateDecayFactor();
+        }
+    }
+
+    double
+    ReinforcementSingleForward::GetIdleRatio(uint32_t direction)
+    {
+        double fluid = m_fluid_traffic != nullptr ? m_fluid_traffic->GetQueueEstimate(m_node_id, direction) : 0.0;
+        return std::max(0.0, 1.0 - (m_queue_trackers[direction]->GetMeanOccupancy() + fluid)/(double) (GetMaxQueueLength()));
+    }
+
     void
     ReinforcementSingleForward::GatherInformation()
     {
         //!<latitude,longitude date rate to neighbor, packet_queue_length,  relative_distance, relative_speed, ISL_state
         //!<north south west east
+        //!<Data rate, packet counters and channel quality are written when their source changes,
+        //!<geometry, queue occupancy and busyness of dynamic routes are read here.
         NS_LOG_FUNCTION (this);
-        Ptr<Node> currentNode = m_topology->GetSatelliteNodes().Get(m_node_id);
-        int feature_vector_position = 0;
         // read latitude and longitude of this satellite and  four neighbor satellites
         for (int i = 0; i < 5 ; ++i) {
-            if(i==0){
-                Ptr<Satellite> currentSatellite  = m_topology->GetSatellite(m_node_id);
-                JulianDate curTime = currentSatellite->GetTleEpoch () + Simulator::Now ();
-                Vector3D currentPosition  = currentSatellite->GetGeographicPosition(curTime);
-                m_information_neighbors[feature_vector_position++]=currentPosition.x/90.0;
-                m_information_neighbors[feature_vector_position++]=currentPosition.y/180.0;
-            }else{
-                Ptr<Satellite> neighborSatellite = m_topology->GetSatellite(m_neighborID.at(i-1));
-                JulianDate curTime = neighborSatellite->GetTleEpoch () + Simulator::Now ();
-                Vector3D neighborPosition = neighborSatellite -> GetGeographicPosition(curTime);
-                m_information_neighbors[feature_vector_position++]=neighborPosition.x/90.0;
-                m_information_neighbors[feature_vector_position++]=neighborPosition.y/180.0;
-            }
+            Ptr<Satellite> satellite = m_topology->GetSatellite(i == 0 ? m_node_id : m_neighborID.at(i-1));
+            JulianDate curTime = satellite->GetTleEpoch () + Simulator::Now ();
+            Vector3D position = satellite->GetGeographicPosition(curTime);
+            m_observation[FEATURE_POSITION + 2*i] = position.x/90.0;
+            m_observation[FEATURE_POSITION + 2*i + 1] = position.y/180.0;
         }
 
-        // read data rate of neighbors
+        // read relative distance and relative velocity
         for (int i = 0; i < 4 ; ++i) {
-            if(m_neighbor_ISL_state.at(i) == ISLState::SHUTDOWN)
-                m_information_neighbors[feature_vector_position++] = 0.0;
-            else
-                m_information_neighbors[feature_vector_position++] = (double)(m_laserDevice_neighbors[i]->GetDataRate().GetBitRate())/10000000.0;
-        }
-        // read mean idle ratio of packet queues
-        for (int i = 0; i < 4 ; ++i) {
-            if(m_count_for_queue_length > 0.0)
-            {
-                m_information_neighbors[feature_vector_position++] = 1.0 - m_mean_queue_length.at(i)/m_count_for_queue_length;
-            }else
-            {
-                m_information_neighbors[feature_vector_position++] = 0.0;
+            if (m_link_geometry != nullptr) {
+                m_observation[FEATURE_DISTANCE + i] = m_link_geometry->GetDistance(m_neighbor_links[i]);
+                m_observation[FEATURE_RELATIVE_SPEED + i] = m_link_geometry->GetRelativeSpeed(m_neighbor_links[i])/280.0;
+            } else {
+                m_observation[FEATURE_DISTANCE + i] = m_mobility->GetDistanceFrom(m_mobility_neighbors[i]);
+                m_observation[FEATURE_RELATIVE_SPEED + i] = m_laserDevice_neighbors[i]->GetRelativeSpeed()/280.0;
             }
         }
 
-        // read relative distance
+        // read time-weighted mean idle ratio and current length of packet queues
+        //!< plus the queue estimated from the fluid background flows, if any
         for (int i = 0; i < 4 ; ++i) {
-            Ptr<MobilityModel> currentMobility  = currentNode->GetObject<MobilityModel>();
-            Ptr<Node> neighborNode = m_topology->GetSatelliteNodes().Get(m_neighborID.at(i));
-            Ptr<MobilityModel> neighborMobility = neighborNode->GetObject<MobilityModel>();
-            m_information_neighbors[feature_vector_position++] = currentMobility->GetDistanceFrom(neighborMobility);
+            double fluid = m_fluid_traffic != nullptr ? m_fluid_traffic->GetQueueEstimate(m_node_id, i) : 0.0;
+            m_observation[FEATURE_IDLE_RATIO + i] = GetIdleRatio(i);
+            m_observation[FEATURE_QUEUE_LENGTH + i] = std::min(1.0, ((double)(m_queue_trackers[i]->GetCurrentOccupancy()) + fluid)/(double) (GetMaxQueueLength()));
         }
 
-        // read relative velocity
-        for (int i = 0; i < 4 ; ++i) {
-            Ptr<MobilityModel> currentMobility  = currentNode->GetObject<MobilityModel>();
-            m_information_neighbors[feature_vector_position++] = m_laserDevice_neighbors[i]->GetRelativeSpeed()/280.0;
+        // read dynamic routes
+        ExpireDynamicRoutes();
+        for (int i = 0; i < 4 ; ++i)
+        {
+            m_observation[FEATURE_BUSYNESS + i] = m_busyness.at(i);
         }
+        m_observation_time = Simulator::Now();
+    }
 
-        // read packet sent of four ISLs
-        for (int i = 0; i < 4; ++i) {
-            m_information_neighbors[feature_vector_position++] = GetPacketsSentCount()[i];
-        }
+    void
+    ReinforcementSingleForward::SetExperienceRing(Ptr<ExperienceRingBuffer> ring)
+    {
+        NS_ASSERT(ring->GetStateDim() == 5 * FEATURE_SIZE);
+        m_experience_ring = ring;
+    }
 
-        // read packet received of four ISLs
-        for (int i = 0; i < 4; ++i) {
-            m_information_neighbors[feature_vector_position++] = GetPacketsReceivedCount()[i];
-        }
+    const MemoryAccount &
+    ReinforcementSingleForward::GetMemoryAccount() const
+    {
+        return m_memory;
+    }
 
-        // read packet sent of Service links (mine and neighbors)
-        for (int i = 0; i < 5 ; ++i)
-        {   if(i==0) {
-                m_information_neighbors[feature_vector_position++] = GetPacketsSentCount()[4];
-            }else {
-                m_information_neighbors[feature_vector_position++] = m_singleForward_neighbors[i-1]-> GetPacketsSentCount()[4];
-            }
+    void
+    ReinforcementSingleForward::SetFlowletGap(Time gap)
+    {
+        m_flowlet_gap = gap;
+        m_flowlets.clear();
+        m_flowlet_sweep_at = 4096;
+    }
+
+    void
+    ReinforcementSingleForward::SetAdaptiveLinkStateBroadcast(Time checkPeriod, double idleRatioThreshold, double dataRateThreshold, Time maxSilence)
+    {
+        NS_ASSERT(checkPeriod.IsStrictlyPositive() && maxSilence >= checkPeriod);
+        m_link_state_adaptive = true;
+        m_link_state_check_period = checkPeriod;
+        m_idle_ratio_threshold = idleRatioThreshold;
+        m_data_rate_threshold = dataRateThreshold;
+        m_link_state_max_silence = maxSilence;
+    }
+
+    uint64_t
+    ReinforcementSingleForward::GetLinkStateUpdatesSent() const
+    {
+        return m_link_state_sent;
+    }
+
+    uint64_t
+    ReinforcementSingleForward::GetLinkStateUpdatesSuppressed() const
+    {
+        return m_link_state_suppressed;
+    }
+
+    uint64_t
+    ReinforcementSingleForward::GetFlowletHits() const
+    {
+        return m_flowlet_hits;
+    }
+
+    uint64_t
+    ReinforcementSingleForward::GetFlowletMisses() const
+    {
+        return m_flowlet_misses;
+    }
+
+    ReinforcementSingleForward::FlowletKey
+    ReinforcementSingleForward::GetFlowletKey(Ptr<const Packet> pkt, const Ipv4Header &ipHeader, int32_t target_node_id) const
+    {
+        FlowletKey key = {ipHeader.GetSource().Get(), ipHeader.GetDestination().Get(), 0, 0, ipHeader.GetProtocol(), target_node_id};
+        //!< The transport header leads the packet while it is routed
+        if (ipHeader.GetProtocol() == UdpL4Protocol::PROT_NUMBER) {
+            UdpHeader udpHeader;
+            pkt->PeekHeader(udpHeader);
+            key.sourcePort = udpHeader.GetSourcePort();
+            key.destinationPort = udpHeader.GetDestinationPort();
         }
+        return key;
+    }
 
-        // read packet received of Service links (mine and neighbors)
-        for (int i = 0; i < 5 ; ++i)
-        {
-            if(i==0){
-                m_information_neighbors[feature_vector_position++] = GetPacketsReceivedCount()[4];
-            }else
-            {
-                m_information_neighbors[feature_vector_position++] = m_singleForward_neighbors[i-1]-> GetPacketsReceivedCount()[4];
-            }
+    void
+    ReinforcementSingleForward::SetPathTracer(Ptr<PathTracer> tracer)
+    {
+        m_path_tracer = tracer;
+    }
+
+    void
+    ReinforcementSingleForward::RecordExperience(double reward, const std::vector<uint32_t> &finalMask, int action,
+                                                 const std::vector<double> &probability)
+    {
+        if (m_experience_ring == nullptr) {
+            return;
         }
-        // read dynamic routes
-        std::vector<double> busyness = CountDynamicRoutes();
-        NS_ASSERT(busyness.size()==4);
-        for (int i = 0; i < 4 ; ++i)
-        {
-            m_information_neighbors[feature_vector_position++] = busyness.at(i);
+        //!< Same observation as the agent reads: my link state, then the tables of four neighbors
+        //!< The block the agent was handed for this query is reused, a query takes no simulated time
+        if (m_observation_time != Simulator::Now()) {
+            GatherInformation();
         }
-        // read current queue length
-        for (int i = 0; i < 4 ; ++i)
-        {
-            m_information_neighbors[feature_vector_position++] = (double)(m_neighbor_queue_size.at(i))/(double) (GetMaxQueueLength());
-        }
-
-        // read channel quality of neighbors
-        for (int i = 0; i < 4 ; ++i) {
-            m_information_neighbors[feature_vector_position++] = m_laserDevice_neighbors[i]->GetDataRateDecayFactor();
+        uint8_t mask[4];
+        float probability_float[4];
+        for (uint32_t i = 0; i < 4; ++i) {
+            mask[i] = (uint8_t) finalMask.at(i);
+            probability_float[i] = (float) probability.at(i);
         }
-
+        m_experience_ring->Push(m_node_id, (uint32_t) action, Simulator::Now().GetNanoSeconds(), (float) reward,
+                                mask, probability_float, &m_observation[OBSERVATION_OWN_TABLE]);
     }
 
     Ptr<MultiAgentGymEnvRouting>
@@ -700,54 +1047,134 @@ namespace ns3 {
     std::vector <double>
     ReinforcementSingleForward::CountDynamicRoutes()
     {
+        ExpireDynamicRoutes();
+        return m_busyness;
+    }
 
-        std::vector <double> busyness = {0.0,0.0,0.0,0.0};
-        std::map <std::string, std::tuple<std::vector<double>, Time>>::iterator action_iter = m_action.begin();
-        while(action_iter != m_action.end())
+    void
+    ReinforcementSingleForward::InstallDynamicRoute(const std::string &mask, const std::vector<double> &probability)
+    {
+        NS_ASSERT(probability.size()==4);
+        ExpireDynamicRoutes();
+        m_action_iter = m_action.find(mask);
+        //!< An entry that is still valid gives its weights back before being replaced
+        if (m_action_iter != m_action.end() && Simulator::Now() < std::get<1>(m_action_iter->second)) {
+            for (int i = 0; i < 4; ++i) {
+                m_busyness.at(i) -= std::get<0>(m_action_iter->second).at(i);
+            }
+        }
+        //!< Jittered lifetime, so that entries created in one burst do not all expire in the same event
+        double ttl = GetGatherPeriod();
+        if (m_route_ttl_jitter > 0.0) {
+            ttl *= 1.0 + m_route_ttl_jitter * (2.0 * m_route_expiry_random.GetUniform() - 1.0);
+        }
+        Time expiry = Simulator::Now() + Seconds(ttl);
+        m_action_generation++;
+        m_action[mask] = std::make_tuple(probability, expiry, m_action_generation, false);
+        for (int i = 0; i < 4; ++i) {
+            m_busyness.at(i) += probability.at(i);
+        }
+        m_action_expiry.push(std::make_tuple(expiry, mask, m_action_generation));
+    }
+
+    void
+    ReinforcementSingleForward::ExpireDynamicRoutes()
+    {
+        while (!m_action_expiry.empty() && std::get<0>(m_action_expiry.top()) <= Simulator::Now())
         {
-            Time record_time = std::get<1>(action_iter->second);
-            std::vector<double> action_probability = std::get<0>(action_iter->second);
-            if(Simulator::Now() - record_time < Seconds(GetGatherPeriod()))
-            {
+            DynamicRouteMap::iterator action_iter =
+                    m_action.find(std::get<1>(m_action_expiry.top()));
+            NS_ASSERT(action_iter != m_action.end());
+            //!< Entries replaced in the meantime have already given their weights back
+            if (std::get<2>(action_iter->second) == std::get<2>(m_action_expiry.top())) {
                 for (int i = 0; i < 4; ++i) {
-                    busyness.at(i)+=action_probability.at(i);
+                    m_busyness.at(i) -= std::get<0>(action_iter->second).at(i);
                 }
             }
-            action_iter++;
+            m_action_expiry.pop();
+        }
+        //!< Avoid accumulating rounding errors once nothing is valid
+        if (m_action_expiry.empty()) {
+            m_busyness = {0.0,0.0,0.0,0.0};
         }
-        return busyness;
     }
 
+    void
+    ReinforcementSingleForward::PrefetchDynamicRoutes()
+    {
+        //!< Collected first, a synchronous query installs into the map being walked
+        std::vector<std::string> due;
+        for (const DynamicRouteMap::value_type &entry : m_action) {
+            const Time &expiry = std::get<1>(entry.second);
+            if (std::get<3>(entry.second) && Simulator::Now() < expiry && expiry <= Simulator::Now() + m_route_prefetch_lead &&
+                m_pending_queries.find(entry.first) == m_pending_queries.end()) {
+                due.push_back(entry.first);
+            }
+        }
+        for (const std::string &mask : due) {
+            std::vector<uint32_t> finalMask(4, 0);
+            for (int i = 0; i < 4; ++i) {
+                finalMask.at(i) = mask.at(i) - '0';
+            }
+            if (m_async_query) {
+                m_pending_queries.insert(mask);
+                Simulator::Schedule(m_async_query_delay, &ReinforcementSingleForward::QueryPolicyAsync, this,
+                                    mask, finalMask);
+            } else {
+                QueryPolicy(mask, finalMask);
+            }
+            m_route_prefetches++;
+        }
+    }
 
     std::vector<uint32_t>
     ReinforcementSingleForward::GetNeighborSatellites(){
         return m_neighborID;
     }
 
+    std::vector<uint32_t>
+    ReinforcementSingleForward::GetLinkNeighbors() const
+    {
+        std::vector<uint32_t> neighbors = m_neighborID;
+        neighbors.insert(neighbors.end(), m_cross_shell_neighborID.begin(), m_cross_shell_neighborID.end());
+        return neighbors;
+    }
+
     std::vector<double>
     ReinforcementSingleForward::GetNeighborInformation(){
         GatherInformation();
-        return m_information_neighbors;
+        return std::vector<double>(m_observation.begin() + OBSERVATION_OWN_TABLE,
+                                   m_observation.begin() + OBSERVATION_OWN_TABLE + FEATURE_SIZE);
     }
 
     std::vector<double>
     ReinforcementSingleForward::GetLinkStateTable(uint32_t neighbor)
     {
-        switch (neighbor)
-        {
-            case 0:
-                return m_information_neighbors_0;
-            case 1:
-                return m_information_neighbors_1;
-            case 2:
-                return m_information_neighbors_2;
-            case 3:
-                return m_information_neighbors_3;
-            default:
-                throw std::runtime_error(format_string(
-                        "satellite %d get wrong neighbor input Id: %d.", m_node_id, neighbor
-                ));
+        if (neighbor >= 4) {
+            throw std::runtime_error(format_string(
+                    "satellite %d get wrong neighbor input Id: %d.", m_node_id, neighbor
+            ));
         }
+        std::vector<float>::const_iterator table = m_observation.begin() + OBSERVATION_NEIGHBOR_TABLES + neighbor * FEATURE_SIZE;
+        return std::vector<double>(table, table + FEATURE_SIZE);
+    }
+
+    const std::vector<float> &
+    ReinforcementSingleForward::GetObservation(const std::vector<uint32_t> &finalMask)
+    {
+        GatherInformation();
+        for (uint32_t i = 0; i < 4; ++i) {
+            m_observation[OBSERVATION_MASK + i] = (float) finalMask.at(i);
+            m_observation[OBSERVATION_NEIGHBOR_IDS + i] = (float) m_neighborID.at(i);
+        }
+        return m_observation;
+    }
+
+    const GraphObservation &
+    ReinforcementSingleForward::GetGraphObservation(const std::vector<uint32_t> &finalMask)
+    {
+        m_graph_observation.Build(GetObservation(finalMask).data(), finalMask);
+        return m_graph_observation;
     }
 
     uint32_t
@@ -760,6 +1187,11 @@ namespace ns3 {
         return m_times_of_using_RL;
     }
 
+    uint64_t
+    ReinforcementSingleForward::GetNumDecisions()const {
+        return m_num_decisions;
+    }
+
     uint32_t
     ReinforcementSingleForward::GetNumberOfMasks()const {
         return m_num_masks;
@@ -773,6 +1205,11 @@ namespace ns3 {
         //!< four mappings <neighbor id,interface number to neighbor>.
         for (int i = 0; i < m_topology->GetNumUndirectedEdges(); i++) {
             std::pair<int64_t, int64_t> edge = m_topology->GetUndirectedEdges().at(i);
+            //!< Link states are only exchanged with the four grid neighbors
+            uint32_t peerId = edge.first == m_node_id ? edge.second : edge.first;
+            if (std::find(m_neighborID.begin(), m_neighborID.end(), peerId) == m_neighborID.end()) {
+                continue;
+            }
             if (edge.first == m_node_id) {
                 uint32_t remoteId = edge.second;
                 Ipv4Address localIpAddress = m_nodes.Get(m_node_id)->GetObject<Ipv4>()->GetAddress(interface_idxs_for_undirected_edges.at(i).first, 0).GetLocal();
@@ -806,11 +1243,35 @@ namespace ns3 {
     void
     ReinforcementSingleForward::BroadCastLinkState()
     {
-        std::vector<double> neighbor_information = GetNeighborInformation();
-        uint32_t count = neighbor_information.size();
-        double bData[neighbor_information.size()];
-        memcpy(bData, &neighbor_information[0], count * sizeof(double_t));
-        Ptr<Packet> packet = Create<Packet> (reinterpret_cast<uint8_t *> (bData), count * sizeof(double_t));
+        const float *table = &m_observation[OBSERVATION_OWN_TABLE];
+        //!< The trigger inputs are read on their own, the whole table is only gathered for a send:
+        //!< ISL states, data rates (maintained when they change) and idle ratios, cheapest first
+        if (m_link_state_adaptive && m_link_state_sent > 0 &&
+                Simulator::Now() - m_last_link_state_time < m_link_state_max_silence) {
+            bool changed = false;
+            for (int i = 0; i < 4 && !changed; ++i) {
+                double lastRate = m_last_link_state[FEATURE_DATA_RATE + i];
+                changed = m_laserDevice_neighbors[i]->GetDeviceState() != m_last_link_state_ISL[i] ||
+                          std::abs(table[FEATURE_DATA_RATE + i] - lastRate) > m_data_rate_threshold * lastRate ||
+                          (lastRate == 0.0 && table[FEATURE_DATA_RATE + i] != 0.0);
+            }
+            for (int i = 0; i < 4 && !changed; ++i) {
+                changed = std::abs(GetIdleRatio(i) - m_last_link_state[FEATURE_IDLE_RATIO + i]) > m_idle_ratio_threshold;
+            }
+            if (!changed) {
+                m_link_state_suppressed++;
+                return;
+            }
+        }
+        GatherInformation();
+        std::copy(table, table + FEATURE_SIZE, m_last_link_state.begin());
+        for (int i = 0; i < 4; ++i) {
+            m_last_link_state_ISL[i] = m_laserDevice_neighbors[i]->GetDeviceState();
+        }
+        m_last_link_state_time = Simulator::Now();
+        m_link_state_sent++;
+        Ptr<Packet> packet = Create<Packet> (reinterpret_cast<const uint8_t *> (&m_observation[OBSERVATION_OWN_TABLE]),
+                                             FEATURE_SIZE * sizeof(float));
         BroadcastTag broadcastTag;
         broadcastTag.SetSource(m_node_id);
         packet->AddPacketTag(broadcastTag);
@@ -822,7 +1283,6 @@ namespace ns3 {
             iter->second->Send(packet);
             iter++;
         }
-        Simulator::Schedule(Seconds(GetGatherPeriod()/2.0),&ReinforcementSingleForward::BroadCastLinkState,this);
     }
 
     void
@@ -841,32 +1301,24 @@ namespace ns3 {
                     if (m_neighborID.at(port) == broadcastTag.GetSource())
                         break;
                 }
-                NS_ASSERT(pkt->GetSize()/sizeof(double)==m_information_neighbors_0.size());
-                uint8_t bData[pkt->GetSize()];
-                pkt->CopyData(bData, sizeof(bData));
-                double *bData_double = reinterpret_cast<double *> (bData);
-                uint32_t array_size = m_information_neighbors.size();
-                switch (port) {
-                    case 0:
-                        memcpy(&m_information_neighbors_0[0], &bData_double[0], array_size * sizeof(double));
-                        break;
-                    case 1:
-                        memcpy(&m_information_neighbors_1[0], &bData_double[0], array_size * sizeof(double));
-                        break;
-                    case 2:
-                        memcpy(&m_information_neighbors_2[0], &bData_double[0], array_size * sizeof(double));
-                        break;
-                    case 3:
-                        memcpy(&m_information_neighbors_3[0], &bData_double[0], array_size * sizeof(double));
-                        break;
-                    default:
-                        break;
+                NS_ASSERT(pkt->GetSize()==FEATURE_SIZE * sizeof(float));
+                if (port < 4) {
+                    //!< The table of the neighbor is copied straight into its slot of the observation block
+                    pkt->CopyData(reinterpret_cast<uint8_t *> (&m_observation[OBSERVATION_NEIGHBOR_TABLES + port * FEATURE_SIZE]),
+                                  FEATURE_SIZE * sizeof(float));
                 }
                 continue;
             }
         }
     }
 
+    int
+    ReinforcementSingleForward::CalculateRemainSteps(int sat1_Id,int sat2_Id)
+    {
+        uint16_t hops = m_shortest_paths->GetDistance(sat1_Id, sat2_Id);
+        return hops == ShortestPathTable::UNREACHABLE ? std::numeric_limits<int>::max() : (int) hops;
+    }
+
     std::string ReinforcementSingleForward::StringReprOfForwardingState() {
         NS_LOG_FUNCTION (this);
         std::ostringstream res;
@@ -874,11 +1326,15 @@ namespace ns3 {
         for (int i = 0; i < m_topology->GetNumSatellites(); i++) {
             res << "  -> " << i << ": {";
             bool first = true;
-            for (int j : m_routing_table.at(i)) {
+            uint8_t next_hop_mask = m_shortest_paths->GetNextHopMask(m_node_id, i);
+            for (uint32_t j = 0; j < ShortestPathTable::MAX_DEGREE; ++j) {
+                if (!((next_hop_mask >> j) & 1)) {
+                    continue;
+                }
                 if (!first) {
                     res << ",";
                 }
-                res << j;
+                res << m_shortest_paths->GetNeighbor(m_node_id, j);
                 first = false;
             }
             res << "}" << std::endl;
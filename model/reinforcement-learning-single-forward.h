@@ -27,6 +27,19 @@
 #include "reinforcement-learning-arbiter.h"
 #include "multi-agent-env.h"
 #include "on-off-isl.h"
+#include "queue-occupancy-tracker.h"
+#include "experience-ring-buffer.h"
+#include "graph-observation.h"
+#include "shortest-path-table.h"
+#include "path-tracer.h"
+#include "memory-accounting.h"
+#include "fluid-traffic-model.h"
+#include "link-geometry-table.h"
+#include <deque>
+#include <functional>
+#include <queue>
+#include <set>
+#include <unordered_map>
 
 
 
@@ -37,8 +50,42 @@ namespace ns3 {
         Drop = 2
     };
 
+    //!< Offsets of the feature groups inside the link-state vector of one satellite.
+    enum LinkStateFeature : uint32_t {
+        FEATURE_POSITION = 0,           //!< latitude and longitude of me and four neighbors
+        FEATURE_DATA_RATE = 10,         //!< data rate of four ISLs
+        FEATURE_IDLE_RATIO = 14,        //!< mean idle ratio of four packet queues
+        FEATURE_DISTANCE = 18,          //!< relative distance to four neighbors
+        FEATURE_RELATIVE_SPEED = 22,    //!< relative speed to four neighbors
+        FEATURE_ISL_SENT = 26,          //!< packets sent of four ISLs
+        FEATURE_ISL_RECEIVED = 30,      //!< packets received of four ISLs
+        FEATURE_SL_SENT = 34,           //!< packets sent of service links (mine and neighbors)
+        FEATURE_SL_RECEIVED = 39,       //!< packets received of service links (mine and neighbors)
+        FEATURE_BUSYNESS = 44,          //!< weights of dynamic routes assigned to four ISLs
+        FEATURE_QUEUE_LENGTH = 48,      //!< current queue length of four ISLs
+        FEATURE_CHANNEL_QUALITY = 52,   //!< channel quality of four ISLs
+        FEATURE_SIZE = 56
+    };
+
+    //!< Layout of the float32 observation block of one satellite, sent to the agent as one frame.
+    enum ObservationLayout : uint32_t {
+        OBSERVATION_OWN_TABLE = 0,                          //!< my link state
+        OBSERVATION_NEIGHBOR_TABLES = FEATURE_SIZE,         //!< link states received from neighbors 0..3
+        OBSERVATION_MASK = 5 * FEATURE_SIZE,                //!< action mask of the query
+        OBSERVATION_NEIGHBOR_IDS = 5 * FEATURE_SIZE + 4,    //!< ids of neighbors 0..3
+        OBSERVATION_SIZE = 5 * FEATURE_SIZE + 8
+    };
+
+
+    //!< Next hop choice while an asynchronous policy query is outstanding.
+    enum class PolicyFallback : uint32_t {
+        STALE,      //!< expired probability vector of the same mask
+        UNIFORM,    //!< uniform over feasible actions
+        QUEUE       //!< feasible action with the shortest queue
+    };
 
     class MultiAgentGymEnvRouting;
+    class SatelliteRoutingTag;
     class ReinforcementSingleForward : public ReinforcementLearningArbiter
     {
     public:
@@ -50,7 +97,7 @@ namespace ns3 {
                 NodeContainer nodes,
                 Ptr<TopologySatellite> satTopology,
                 Ptr<MultiAgentGymEnvRouting> agentGymEnv,
-                std::vector<std::vector<uint32_t>>  routing_table
+                Ptr<ShortestPathTable> shortestPaths
         );
 
         virtual ~ReinforcementSingleForward();
@@ -67,12 +114,32 @@ namespace ns3 {
         );
         //!< print static routing table
         std::string StringReprOfForwardingState();
+        //!< Hops over the ISLs that are up, read from the shared shortest path table
+        int CalculateRemainSteps(int sat1_Id,int sat2_Id);
         //!<Get the ID of neighbor satellites to fill observe space.
         std::vector<uint32_t> GetNeighborSatellites();
-        //!<Return vector of neighbor information.
+        //!<Neighbors in next-hop table slot order: the four directions, then the cross-shell neighbors.
+        std::vector<uint32_t> GetLinkNeighbors() const;
+        //!<Return vector of neighbor information, a copy of my table in the observation block.
         std::vector<double> GetNeighborInformation();
-        //!<The real function to gather information.
+        /**
+        * Refresh my link state and return the whole observation block: five link-state tables,
+        * the mask of the query and the neighbor ids, see ObservationLayout.
+        * @param finalMask the mask handed to ObserveNow, a prefetch query is not the current packet
+        * @return contiguous float32 block, valid until the next call
+        */
+        const std::vector<float> &GetObservation(const std::vector<uint32_t> &finalMask);
+        /**
+        * Refresh the observation block and build the graph input of the policy from it,
+        * so that the agent only wraps the buffers into tensors.
+        * @param finalMask the mask handed to ObserveNow
+        * @return node features, edge features and edge index of the query
+        */
+        const GraphObservation &GetGraphObservation(const std::vector<uint32_t> &finalMask);
+        //!<Refresh the time-varying feature groups, the others are maintained when their source changes.
         void GatherInformation();
+        //!<Time-weighted mean idle ratio of an ISL queue, fluid background included.
+        double GetIdleRatio(uint32_t direction);
         //!<Get environment of ns3-gym
         Ptr<MultiAgentGymEnvRouting> GetGymEnvRouting();
         //!<Get period of gather information
@@ -101,12 +168,20 @@ namespace ns3 {
 
         /**
         * Return the reward to the agent, while updating the routingTag.
-        * @param pkt pointer of packet
+        * @param routingTag tag peeked from the packet, updated in place and handed to the device once
         * @param resultLastDecision Result of this route caused by the last decision
         * @param nextSatellite satellite id
         */
-        void UpdatingRoutingTagReturnReward(ns3::Ptr<const ns3::Packet> pkt,
+        void UpdatingRoutingTagReturnReward(SatelliteRoutingTag &routingTag,
                                             resultLastDecision result, uint32_t nextSatellite);
+        /**
+        * Forward over a cross-shell ISL, which is not one of the four actions: the hop is recorded in the tag
+        * without a decision to reward.
+        * @param routingTag tag peeked from the packet, updated in place and handed to the device
+        * @param index position of the neighbor in m_cross_shell_neighborID
+        * @return the cross-shell neighbor
+        */
+        uint32_t ForwardOnCrossShellLink(SatelliteRoutingTag &routingTag, uint32_t index);
         /**
          * Record the reward received by the agent to the corresponding action.
          * @param packet_Id unique Id of packet.
@@ -133,16 +208,21 @@ namespace ns3 {
         */
         void UpdatingPacketCount();
 
+        /**
+        * Node-local part of the counter update, safe to run on a worker thread.
+        */
+        void CountPackets();
 
         /**
-        * Easy to read neighbor information.
+        * Push the service link counters to the four neighbors.
         */
-        void RecordInterfaces();
+        void PublishServiceLinkCount();
+
 
         /**
-        * Reset queue length tracer every 1.0 seconds.
+        * Easy to read neighbor information.
         */
-        void ReSetQueueLength();
+        void RecordInterfaces();
 
         /**
         * Get maximum queue length.
@@ -156,12 +236,105 @@ namespace ns3 {
         */
         std::vector <double>  CountDynamicRoutes();
 
+        /**
+        * Install a probability vector as dynamic route of a mask and account it in the busyness features.
+        * @param mask key of the dynamic routing entry
+        * @param probability probability of four actions
+        */
+        void InstallDynamicRoute(const std::string &mask, const std::vector<double> &probability);
+
+        /**
+        * Remove the weights of expired dynamic routes from the busyness features.
+        */
+        void ExpireDynamicRoutes();
+
+        /**
+        * Query the policy again for dynamic routes in use that expire within the prefetch lead,
+        * called by the constellation tick scheduler every prefetch lead.
+        */
+        void PrefetchDynamicRoutes();
+
+        /**
+        * Refresh data rate and channel quality features, called when capacity or state of an ISL changes.
+        */
+        void UpdateChannelFeatures();
+
+        /**
+        * Store the service link counters a neighbor pushed after its own counter update.
+        * @param direction direction of that neighbor
+        * @param sent packets sent of its service links
+        * @param received packets received of its service links
+        */
+        void SetNeighborServiceLinkCount(uint32_t direction, uint32_t sent, uint32_t received);
+
+        /**
+        * Stream every policy query to a shared memory ring for an external learner.
+        * @param ring opened experience ring, shared by all satellites
+        */
+        void SetExperienceRing(Ptr<ExperienceRingBuffer> ring);
+
+        /**
+        * Record the hops of sampled packets.
+        * @param tracer path tracer, shared by all satellites
+        */
+        void SetPathTracer(Ptr<PathTracer> tracer);
+
+        /**
+        * Append the state, mask, sampled action and reward of a policy query to the ring.
+        * @param reward reward returned to the agent with this query
+        * @param finalMask mask sent to the agent
+        * @param action action sampled from the returned probability
+        * @param probability probability of four actions returned by the agent
+        */
+        void RecordExperience(double reward, const std::vector<uint32_t> &finalMask, int action,
+                              const std::vector<double> &probability);
+
+        /**
+        * Send the observation of a mask to the agent and install the returned probability as dynamic route.
+        * @param mask key of the dynamic routing entry
+        * @param finalMask mask sent to the agent
+        * @return action sampled from the returned probability
+        */
+        int QueryPolicy(const std::string &mask, std::vector<uint32_t> finalMask);
+
+        /**
+        * Forward without waiting for the agent: expired or unknown masks are queried in a separate
+        * event after a fixed delay, packets meanwhile follow the fallback.
+        * @param enable use asynchronous policy queries
+        * @param delay simulation time between the first miss of a mask and its query
+        * @param fallback stale (expired vector of the mask, queue if none), uniform or queue
+        */
+        void SetAsyncPolicyQuery(bool enable, Time delay, std::string fallback);
+
+        /**
+        * Stagger the expiry of dynamic routes and refresh the ones in use before they expire.
+        * Must be called before RecordInterfaces.
+        * @param ttlJitter lifetime of an entry drawn uniformly in gather period * [1 - ttlJitter, 1 + ttlJitter]
+        * @param prefetchLead entries used since installation are queried again this long before
+        *        they expire, asynchronously in asynchronous mode, zero disables
+        */
+        void SetDynamicRouteRefresh(double ttlJitter, Time prefetchLead);
+
+        uint64_t GetNumPrefetchedRoutes() const;
+
+        /**
+        * Static routing table shared by all satellites, repaired when an ISL changes state.
+        * @return the shortest path table
+        */
+        Ptr<ShortestPathTable> GetShortestPathTable() const;
+
         /**
         * Verify that RL is not being called frequently.
         * @return the times of using RL.
         */
         uint32_t GetTimesUsingRL()const;
 
+        /**
+        * Routing decisions taken by RLDecisionMaking or reused from the flowlet cache.
+        * @return the number of decisions.
+        */
+        uint64_t GetNumDecisions()const;
+
         /**
         * Verify that RL is not being called frequently.
         * @return the number of masks.
@@ -174,10 +347,24 @@ namespace ns3 {
         void NotifyDisconnection(bool interference);
 
         /**
-         * Broadcast Link State periodically
+         * Broadcast Link State, called by the constellation tick scheduler every check period,
+         * by default half the gather period. In adaptive mode the table is only sent when it changed enough.
          */
         void BroadCastLinkState();
 
+        /**
+        * Send my link state only when a feature group moved beyond its threshold since the last send,
+        * or when nothing was sent for maxSilence. Must be called before RecordInterfaces.
+        * @param checkPeriod time between two checks
+        * @param idleRatioThreshold absolute change of the idle ratio of any ISL queue
+        * @param dataRateThreshold change of the data rate of any ISL, relative to the last one sent
+        * @param maxSilence longest time without a send, changes of ISL state are always sent
+        */
+        void SetAdaptiveLinkStateBroadcast(Time checkPeriod, double idleRatioThreshold, double dataRateThreshold, Time maxSilence);
+
+        uint64_t GetLinkStateUpdatesSent() const;
+        uint64_t GetLinkStateUpdatesSuppressed() const;
+
         /**
         * Store link state from neighbor.
         */
@@ -186,61 +373,167 @@ namespace ns3 {
 
         std::vector<double> GetLinkStateTable(uint32_t neighbor);
 
+        /**
+        * Bytes used by this satellite per memory category.
+        */
+        const MemoryAccount &GetMemoryAccount() const;
+
+        /**
+        * Reuse the next hop of the previous packet of a flow while packets are less than gap apart.
+        * @param gap inter-packet gap closing a flowlet, zero disables the cache
+        */
+        void SetFlowletGap(Time gap);
+
+        uint64_t GetFlowletHits() const;
+        uint64_t GetFlowletMisses() const;
+
 
 
     private:
+        //!< Containers that grow with traffic, counted under the memory account of this satellite
+        typedef std::map<std::string, double, std::less<std::string>,
+                AccountedAllocator<std::pair<const std::string, double>>> RewardMap;
+        typedef std::map<std::string, uint32_t, std::less<std::string>,
+                AccountedAllocator<std::pair<const std::string, uint32_t>>> CountMap;
+        typedef std::map<std::string, std::tuple<std::vector<double>, Time, uint64_t, bool>, std::less<std::string>,
+                AccountedAllocator<std::pair<const std::string, std::tuple<std::vector<double>, Time, uint64_t, bool>>>> DynamicRouteMap;
+        typedef std::priority_queue<std::tuple<Time, std::string, uint64_t>,
+                std::vector<std::tuple<Time, std::string, uint64_t>, AccountedAllocator<std::tuple<Time, std::string, uint64_t>>>,
+                std::greater<std::tuple<Time, std::string, uint64_t>>> RouteExpiryQueue;
+        typedef std::map<uint32_t, std::string, std::less<uint32_t>,
+                AccountedAllocator<std::pair<const uint32_t, std::string>>> PacketActionMap;
+        typedef std::set<std::string, std::less<std::string>, AccountedAllocator<std::string>> PendingQuerySet;
+
+        //!< Addresses, ports and protocol of a packet, with the target satellite of the decision
+        struct FlowletKey {
+            uint32_t source;
+            uint32_t destination;
+            uint16_t sourcePort;
+            uint16_t destinationPort;
+            uint8_t protocol;
+            int32_t targetSatellite;
+            bool operator== (const FlowletKey &other) const
+            {
+                return source == other.source && destination == other.destination && sourcePort == other.sourcePort &&
+                       destinationPort == other.destinationPort && protocol == other.protocol && targetSatellite == other.targetSatellite;
+            }
+        };
+        struct FlowletKeyHash {
+            size_t operator() (const FlowletKey &key) const
+            {
+                uint64_t a = ((uint64_t) key.source << 32) | key.destination;
+                uint64_t b = ((uint64_t) key.sourcePort << 48) | ((uint64_t) key.destinationPort << 32) |
+                             ((uint64_t) key.protocol << 24);
+                b ^= (uint32_t) key.targetSatellite;
+                return std::hash<uint64_t>()(a * 0x9E3779B97F4A7C15ULL ^ b);
+            }
+        };
+        struct Flowlet {
+            Time lastSeen;
+            int nextHop;
+            std::string mask;   //!< mask of the policy decision the hop came from, empty for a forced hop
+        };
+        FlowletKey GetFlowletKey(Ptr<const Packet> pkt, const Ipv4Header &ipHeader, int32_t target_node_id) const;
+        //!< Record the packet under the mask of its policy decision and wait for the feedback of reward
+        void WaitForReward(const SatelliteRoutingTag &routingTag, Ptr<const Packet> pkt, int32_t target_node_id, const std::string &mask);
+
+        //!< Scheduled policy query of a mask in asynchronous mode
+        void QueryPolicyAsync(std::string mask, std::vector<uint32_t> finalMask);
+        //!< Next hop of an expired or unknown mask while its query is outstanding
+        int GetFallbackAction(const std::string &mask);
+
+        //!< Declared first so that it outlives the containers it counts
+        MemoryAccount m_memory;
         //!<ns3-gym environment
         Ptr<MultiAgentGymEnvRouting> m_agentGymEnv;
-        //!<Link information from neighbors
-        std::vector<double> m_information_neighbors;
-        //!<information of neighbors collected by neighbor 0 (second-order)
-        std::vector<double> m_information_neighbors_0;
-        //!<information of neighbors collected by neighbor 1 (second-order)
-        std::vector<double> m_information_neighbors_1;
-        //!<information of neighbors collected by neighbor 2 (second-order)
-        std::vector<double> m_information_neighbors_2;
-        //!<information of neighbors collected by neighbor 3 (second-order)
-        std::vector<double> m_information_neighbors_3;
+        //!<Link information of me, then of neighbors 0..3 (second-order), then mask and neighbor ids
+        std::vector<float> m_observation;
+        //!<When the time-varying features were last gathered
+        Time m_observation_time;
+        GraphObservation m_graph_observation;
         std::vector<Ptr<ReinforcementSingleForward>> m_singleForward_neighbors;
         std::vector<Ptr<LaserNetDevice>> m_laserDevice_neighbors;
+        std::vector<Ptr<LaserNetDevice>> m_laserDevice_cross_shell;
         std::vector<Ptr<ServiceLinkNetDevice>> m_service_linkDevices;
+        //!< My direction as seen by each of the four neighbors.
+        std::vector<uint32_t> m_direction_at_neighbor;
+        Ptr<MobilityModel> m_mobility;
+        std::vector<Ptr<MobilityModel>> m_mobility_neighbors;
         uint32_t m_capacity;
         //!<period for acquiring new strategies at the end of training
         double m_period_gather_neighbors;
-        //!<static routing table
-        typedef std::vector<std::vector<uint32_t>> routing_table;
-        routing_table m_routing_table;
-        routing_table::iterator m_routes_iter;
+        //!<static routing table of all satellites, shared, bit i of my next-hop mask is m_neighborID.at(i)
+        Ptr<ShortestPathTable> m_shortest_paths;
         //!<m_rotingType
         RoutingProtocol m_rotingType;
         //!< mapping for masks and Corresponding rewards.
-        std::map <std::string, double> m_reward;
-        std::map <std::string, double>::iterator m_reward_iter;
-        std::map <std::string, uint32_t> m_count;
-        std::map <std::string, uint32_t>::iterator m_count_iter;
-        //!< mapping for masks, Corresponding action and valid time. That is, dynamic routing tables
-        std::map <std::string, std::tuple<std::vector<double>, Time>> m_action;
-        std::map <std::string, std::tuple<std::vector<double>, Time>>::iterator m_action_iter;
+        RewardMap m_reward;
+        RewardMap::iterator m_reward_iter;
+        CountMap m_count;
+        CountMap::iterator m_count_iter;
+        //!< mapping for masks, Corresponding action, expiry time, generation and use since installation. That is, dynamic routing tables
+        DynamicRouteMap m_action;
+        DynamicRouteMap::iterator m_action_iter;
+        //!< Min-heap of dynamic routes by expiry <time, mask, generation>, used to expire their busyness.
+        RouteExpiryQueue m_action_expiry;
+        //!< Jittered lifetime of dynamic routes and refresh ahead of expiry
+        double m_route_ttl_jitter;
+        Time m_route_prefetch_lead;
+        PhiloxRandomStream m_route_expiry_random;
+        uint64_t m_route_prefetches;
+        //!< Sum of valid probability vectors, kept up to date on installation and expiry.
+        std::vector <double> m_busyness;
+        uint64_t m_action_generation;
         //!< The number of packet sent and received of service links and four ISL links.
         std::vector<uint32_t> m_send_vector;
         std::vector<uint32_t> m_receive_vector;
         //!< mapping for packet id and Corresponding action.
         //!< trace rewards.
-        std::map <uint32_t, std::string> m_packet_action;
-        std::map <uint32_t, std::string>::iterator m_packet_action_iter;
+        PacketActionMap m_packet_action;
+        PacketActionMap::iterator m_packet_action_iter;
         //!< Only actions that require a choice from two or three direction will need a reward return
         bool m_wait_reward;
         //!< Record ISL state of four neighbors
         std::vector <ISLState> m_neighbor_ISL_state;
+        //!< Link-state dissemination, fixed period or change triggered
+        Time m_link_state_check_period;
+        bool m_link_state_adaptive;
+        double m_idle_ratio_threshold;
+        double m_data_rate_threshold;
+        Time m_link_state_max_silence;
+        //!< Table, ISL states and time of the last send
+        std::vector<float> m_last_link_state;
+        std::vector <ISLState> m_last_link_state_ISL;
+        Time m_last_link_state_time;
+        uint64_t m_link_state_sent;
+        uint64_t m_link_state_suppressed;
         //!< Record Queue size state of four neighbors
         std::vector <uint32_t> m_neighbor_queue_size;
         uint32_t  m_max_queue_size;
         //!< key for finding routing entry.
         std::vector <uint32_t> m_final_mask;
-        //!< For calculating mean queue length.
-        std::vector <double> m_mean_queue_length;
-        double m_count_for_queue_length;
+        //!< Time-weighted occupancy of the four ISL queues.
+        std::vector <Ptr<QueueOccupancyTracker>> m_queue_trackers;
+        //!< Queue estimates of the background flows modeled as fluid, nullptr if none.
+        Ptr<FluidTrafficModel> m_fluid_traffic;
+        //!< Sampled geometry of the ISLs and the edge index of the four neighbor links, nullptr if none.
+        Ptr<LinkGeometryTable> m_link_geometry;
+        std::vector <uint32_t> m_neighbor_links;
+        Ptr<ExperienceRingBuffer> m_experience_ring;
+        Ptr<PathTracer> m_path_tracer;
+        //!< flowlet cache of next hops, per flow
+        Time m_flowlet_gap;
+        std::unordered_map<FlowletKey, Flowlet, FlowletKeyHash> m_flowlets;
+        uint64_t m_flowlet_hits;
+        uint64_t m_flowlet_misses;
+        size_t m_flowlet_sweep_at;      //!< cache size that triggers the next sweep of closed flowlets
+        //!< asynchronous policy queries
+        bool m_async_query;
+        Time m_async_query_delay;
+        PolicyFallback m_async_fallback;
+        PendingQuerySet m_pending_queries;
         uint32_t m_times_of_using_RL;
+        uint64_t m_num_decisions;
         uint32_t m_num_masks;
         //!< next hop for single forward.
         int m_next_hop;
@@ -0,0 +1,212 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "satellite-spatial-index.h"
+#include "constellation-tick-scheduler.h"
+#include "parallel-for.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+    NS_LOG_COMPONENT_DEFINE ("SatelliteSpatialIndex");
+    NS_OBJECT_ENSURE_REGISTERED (SatelliteSpatialIndex);
+
+    namespace {
+        const double EARTH_RADIUS_M = 6371000.0;
+        const double DEG_TO_RAD = M_PI / 180.0;
+    }
+
+    TypeId
+    SatelliteSpatialIndex::GetTypeId (void)
+    {
+        static TypeId tid = TypeId ("ns3::SatelliteSpatialIndex")
+                .SetParent<Object> ()
+                .SetGroupName("RoutingRL")
+        ;
+        return tid;
+    }
+
+    SatelliteSpatialIndex::SatelliteSpatialIndex (Ptr<TopologySatellite> topology, double cellDegrees, double minElevationDeg)
+    {
+        NS_ASSERT(cellDegrees > 0.0 && cellDegrees <= 90.0);
+        m_topology = topology;
+        m_cellDegrees = cellDegrees;
+        m_minElevation = minElevationDeg * DEG_TO_RAD;
+        m_numLatCells = (uint32_t) std::ceil(180.0 / cellDegrees);
+        m_numLonCells = (uint32_t) std::ceil(360.0 / cellDegrees);
+        m_coverageAngle = 0.0;
+        uint32_t numSatellites = topology->GetNumSatellites();
+        m_latitude = std::vector<double>(numSatellites, 0.0);
+        m_longitude = std::vector<double>(numSatellites, 0.0);
+        m_altitude = std::vector<double>(numSatellites, 0.0);
+        m_cellStart = std::vector<uint32_t>(m_numLatCells * m_numLonCells + 1, 0);
+        m_cellSatellites = std::vector<uint32_t>(numSatellites, 0);
+    }
+
+    SatelliteSpatialIndex::~SatelliteSpatialIndex ()
+    {
+    }
+
+    void
+    SatelliteSpatialIndex::DoDispose (void)
+    {
+        //!< Aggregated to the topology it points to, break the cycle
+        m_topology = nullptr;
+        Object::DoDispose();
+    }
+
+    uint32_t
+    SatelliteSpatialIndex::CellOf (double latitude, double longitude) const
+    {
+        uint32_t row = std::min(m_numLatCells - 1, (uint32_t) std::max(0.0, (latitude + 90.0) / m_cellDegrees));
+        double wrapped = longitude - 360.0 * std::floor((longitude + 180.0) / 360.0);
+        uint32_t column = std::min(m_numLonCells - 1, (uint32_t) std::max(0.0, (wrapped + 180.0) / m_cellDegrees));
+        return row * m_numLonCells + column;
+    }
+
+    void
+    SatelliteSpatialIndex::Refresh (void)
+    {
+        uint32_t numSatellites = m_latitude.size();
+        //!< Propagation is independent per satellite
+        ParallelFor(ConstellationTickScheduler::Get()->GetNumThreads(), numSatellites, [this] (uint32_t i) {
+            Ptr<Satellite> satellite = m_topology->GetSatellite(i);
+            JulianDate curTime = satellite->GetTleEpoch () + Simulator::Now ();
+            Vector3D position = satellite->GetGeographicPosition(curTime);
+            m_latitude[i] = position.x;
+            m_longitude[i] = position.y;
+            m_altitude[i] = position.z;
+        });
+
+        //!< Counting sort of the satellites by cell
+        std::fill(m_cellStart.begin(), m_cellStart.end(), 0);
+        double maxAltitude = 0.0;
+        for (uint32_t i = 0; i < numSatellites; ++i) {
+            m_cellStart[CellOf(m_latitude[i], m_longitude[i]) + 1]++;
+            maxAltitude = std::max(maxAltitude, m_altitude[i]);
+        }
+        for (uint32_t c = 1; c < m_cellStart.size(); ++c) {
+            m_cellStart[c] += m_cellStart[c - 1];
+        }
+        std::vector<uint32_t> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+        for (uint32_t i = 0; i < numSatellites; ++i) {
+            m_cellSatellites[fill[CellOf(m_latitude[i], m_longitude[i])]++] = i;
+        }
+
+        //!< Earth central angle at which the elevation drops to the minimum
+        m_coverageAngle = std::acos(EARTH_RADIUS_M / (EARTH_RADIUS_M + maxAltitude) * std::cos(m_minElevation)) - m_minElevation;
+        m_lastRefresh = Simulator::Now();
+    }
+
+    void
+    SatelliteSpatialIndex::Start (Time period)
+    {
+        Refresh();
+        Ptr<ConstellationTickScheduler> ticks = ConstellationTickScheduler::Get();
+        ticks->Subscribe(ticks->GetTaskClass("RefreshSatelliteSpatialIndex", period, period),
+                         MakeCallback(&SatelliteSpatialIndex::Refresh, this));
+    }
+
+    double
+    SatelliteSpatialIndex::GetCentralAngle (double latitude, double longitude, uint32_t satellite) const
+    {
+        double lat1 = latitude * DEG_TO_RAD;
+        double lat2 = m_latitude.at(satellite) * DEG_TO_RAD;
+        double dLat = lat2 - lat1;
+        double dLon = (m_longitude.at(satellite) - longitude) * DEG_TO_RAD;
+        double h = std::sin(dLat / 2) * std::sin(dLat / 2) + std::cos(lat1) * std::cos(lat2) * std::sin(dLon / 2) * std::sin(dLon / 2);
+        return 2.0 * std::asin(std::min(1.0, std::sqrt(h)));
+    }
+
+    double
+    SatelliteSpatialIndex::GetElevation (double latitude, double longitude, uint32_t satellite) const
+    {
+        //!< Elevation from the central angle and the altitude of the satellite
+        double gamma = GetCentralAngle(latitude, longitude, satellite);
+        double r = EARTH_RADIUS_M + m_altitude.at(satellite);
+        return std::atan2(std::cos(gamma) - EARTH_RADIUS_M / r, std::sin(gamma));
+    }
+
+    void
+    SatelliteSpatialIndex::GetCandidates (double latitude, double longitude, std::vector<uint32_t> &candidates) const
+    {
+        candidates.clear();
+        double radiusDeg = m_coverageAngle / DEG_TO_RAD;
+        double latMin = std::max(-90.0, latitude - radiusDeg);
+        double latMax = std::min(90.0, latitude + radiusDeg);
+        uint32_t rowMin = CellOf(latMin, 0.0) / m_numLonCells;
+        uint32_t rowMax = CellOf(latMax, 0.0) / m_numLonCells;
+        //!< Longitude span of the coverage cap, the whole circle once the cap reaches a pole
+        double maxAbsLat = std::max(std::fabs(latMin), std::fabs(latMax));
+        uint32_t columnSpan = m_numLonCells;
+        if (maxAbsLat < 89.0) {
+            double lonRadius = radiusDeg / std::cos(maxAbsLat * DEG_TO_RAD);
+            columnSpan = std::min(m_numLonCells, (uint32_t) std::ceil(lonRadius / m_cellDegrees) * 2 + 1);
+        }
+        uint32_t centerColumn = CellOf(0.0, longitude) % m_numLonCells;
+        uint32_t firstColumn = (centerColumn + m_numLonCells - columnSpan / 2) % m_numLonCells;
+        for (uint32_t row = rowMin; row <= rowMax; ++row) {
+            for (uint32_t k = 0; k < columnSpan; ++k) {
+                uint32_t cell = row * m_numLonCells + (firstColumn + k) % m_numLonCells;
+                for (uint32_t j = m_cellStart[cell]; j < m_cellStart[cell + 1]; ++j) {
+                    uint32_t satellite = m_cellSatellites[j];
+                    if (GetElevation(latitude, longitude, satellite) >= m_minElevation) {
+                        candidates.push_back(satellite);
+                    }
+                }
+            }
+        }
+    }
+
+    int32_t
+    SatelliteSpatialIndex::GetBestSatellite (double latitude, double longitude) const
+    {
+        std::vector<uint32_t> candidates;
+        GetCandidates(latitude, longitude, candidates);
+        int32_t best = -1;
+        double bestElevation = -M_PI;
+        for (uint32_t satellite : candidates) {
+            double elevation = GetElevation(latitude, longitude, satellite);
+            if (elevation > bestElevation) {
+                bestElevation = elevation;
+                best = satellite;
+            }
+        }
+        return best;
+    }
+
+    double
+    SatelliteSpatialIndex::GetCoverageAngle (void) const
+    {
+        return m_coverageAngle;
+    }
+
+    Time
+    SatelliteSpatialIndex::GetLastRefresh (void) const
+    {
+        return m_lastRefresh;
+    }
+
+}
@@ -0,0 +1,114 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#ifndef SATELLITE_NETWORK_SATELLITE_SPATIAL_INDEX_H
+#define SATELLITE_NETWORK_SATELLITE_SPATIAL_INDEX_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/topology-satellites.h"
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * Grid of sub-satellite points on equal-angle latitude/longitude cells, refreshed once per
+     * time step, to find the satellites that see a ground location above the minimum elevation.
+     *
+     * A query only visits the cells within the coverage radius of the location, so its cost
+     * depends on the cell size and the constellation density, not on the number of satellites
+     * or terminals. The index is aggregated to the topology, components holding the topology
+     * find it with GetObject<SatelliteSpatialIndex>().
+     */
+    class SatelliteSpatialIndex : public Object
+    {
+    public:
+        static TypeId GetTypeId (void);
+
+        /**
+         * @param topology          satellites to index
+         * @param cellDegrees       side of a grid cell in degrees
+         * @param minElevationDeg   minimum elevation for a satellite to serve a ground location
+         */
+        SatelliteSpatialIndex (Ptr<TopologySatellite> topology, double cellDegrees, double minElevationDeg);
+        ~SatelliteSpatialIndex ();
+
+        /**
+         * Recompute sub-satellite points for the current simulation time and rebuild the grid.
+         */
+        void Refresh (void);
+
+        /**
+         * Refresh now and then periodically on the constellation tick scheduler.
+         */
+        void Start (Time period);
+
+        /**
+         * Satellites above the minimum elevation of a ground location.
+         * @param latitude      degrees
+         * @param longitude     degrees
+         * @param candidates    cleared, then filled with satellite ids
+         */
+        void GetCandidates (double latitude, double longitude, std::vector<uint32_t> &candidates) const;
+
+        /**
+         * @return the satellite at the highest elevation for a ground location, -1 if none is visible
+         */
+        int32_t GetBestSatellite (double latitude, double longitude) const;
+
+        /**
+         * @return great circle angle (radians) between a ground location and a sub-satellite point
+         */
+        double GetCentralAngle (double latitude, double longitude, uint32_t satellite) const;
+
+        /**
+         * @return elevation (radians) of a satellite seen from a ground location, negative below the horizon
+         */
+        double GetElevation (double latitude, double longitude, uint32_t satellite) const;
+
+        //!< Largest central angle (radians) at which a satellite is still above the minimum elevation
+        double GetCoverageAngle (void) const;
+
+        Time GetLastRefresh (void) const;
+
+    protected:
+        virtual void DoDispose (void);
+
+    private:
+        uint32_t CellOf (double latitude, double longitude) const;
+        Ptr<TopologySatellite> m_topology;
+        double m_cellDegrees;
+        double m_minElevation;                  //!< radians
+        uint32_t m_numLatCells;
+        uint32_t m_numLonCells;
+        double m_coverageAngle;                 //!< radians, from the highest satellite of the last refresh
+        std::vector<double> m_latitude;         //!< degrees, per satellite
+        std::vector<double> m_longitude;        //!< degrees, per satellite
+        std::vector<double> m_altitude;         //!< meters, per satellite
+        std::vector<uint32_t> m_cellStart;      //!< satellites of cell c are m_cellSatellites[m_cellStart[c], m_cellStart[c+1])
+        std::vector<uint32_t> m_cellSatellites;
+        Time m_lastRefresh;
+    };
+
+}
+
+#endif //SATELLITE_NETWORK_SATELLITE_SPATIAL_INDEX_H
@@ -0,0 +1,382 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "shortest-path-table.h"
+#include "parallel-for.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+
+namespace ns3 {
+
+    NS_LOG_COMPONENT_DEFINE ("ShortestPathTable");
+    NS_OBJECT_ENSURE_REGISTERED (ShortestPathTable);
+
+    TypeId
+    ShortestPathTable::GetTypeId (void)
+    {
+        static TypeId tid = TypeId ("ns3::ShortestPathTable")
+                .SetParent<Object> ()
+                .SetGroupName("RoutingRL")
+        ;
+        return tid;
+    }
+
+    ShortestPathTable::ShortestPathTable (uint32_t numNodes)
+        : m_distance(AccountedAllocator<uint16_t>(nullptr, MemoryCategory::ROUTING_TABLES)),
+          m_nextHopMask(AccountedAllocator<uint8_t>(nullptr, MemoryCategory::ROUTING_TABLES))
+    {
+        if (numNodes >= UNREACHABLE) {
+            throw std::runtime_error("Too many nodes for 16-bit hop distances");
+        }
+        m_numNodes = numNodes;
+        m_numThreads = 1;
+        m_neighbors = std::vector<std::vector<uint32_t>>(numNodes);
+        m_reverseSlot = std::vector<std::vector<uint32_t>>(numNodes);
+        m_linkUp = std::vector<uint8_t>(numNodes, 0);
+        m_lastRepairedEntries = 0;
+    }
+
+    ShortestPathTable::~ShortestPathTable ()
+    {
+    }
+
+    void
+    ShortestPathTable::SetNeighbors (uint32_t node, const std::vector<uint32_t> &neighbors)
+    {
+        NS_ASSERT(node < m_numNodes);
+        if (neighbors.size() > MAX_DEGREE) {
+            throw std::runtime_error("Node has more neighbors than next-hop mask bits");
+        }
+        for (uint32_t neighbor : neighbors) {
+            NS_ASSERT(neighbor < m_numNodes);
+        }
+        m_neighbors.at(node) = neighbors;
+        m_linkUp.at(node) = (uint8_t) ((1u << neighbors.size()) - 1);
+    }
+
+    uint32_t
+    ShortestPathTable::FindSlot (uint32_t node, uint32_t neighbor) const
+    {
+        const std::vector<uint32_t> &neighbors = m_neighbors.at(node);
+        for (uint32_t slot = 0; slot < neighbors.size(); ++slot) {
+            if (neighbors[slot] == neighbor) {
+                return slot;
+            }
+        }
+        throw std::runtime_error("Nodes " + std::to_string(node) + " and " + std::to_string(neighbor) + " are not neighbors");
+    }
+
+    void
+    ShortestPathTable::Compute (uint32_t numThreads)
+    {
+        numThreads = std::max(1u, std::min(numThreads, m_numNodes));
+        m_numThreads = numThreads;
+        for (uint32_t node = 0; node < m_numNodes; ++node) {
+            m_reverseSlot[node].clear();
+            for (uint32_t neighbor : m_neighbors[node]) {
+                m_reverseSlot[node].push_back(FindSlot(neighbor, node));
+            }
+        }
+        m_distance.assign((size_t) m_numNodes * m_numNodes, (uint16_t) UNREACHABLE);
+        m_nextHopMask.assign((size_t) m_numNodes * m_numNodes, 0);
+        m_threadSeconds = std::vector<double>(numThreads, 0.0);
+        m_threadTargets = std::vector<uint32_t>(numThreads, 0);
+        m_threadRepaired = std::vector<uint64_t>(numThreads, 0);
+        m_scratch = std::vector<RepairScratch>(numThreads);
+        for (RepairScratch &scratch : m_scratch) {
+            scratch.queue = std::vector<uint32_t>(m_numNodes);
+            scratch.affected = std::vector<uint8_t>(m_numNodes, 0);
+        }
+        //!< Thread k takes targets k, k + numThreads, ... so that the load stays even
+        ParallelFor(numThreads, numThreads, [this, numThreads] (uint32_t k) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            std::vector<uint32_t> queue(m_numNodes);
+            for (uint32_t target = k; target < m_numNodes; target += numThreads) {
+                ComputeTarget(target, queue);
+                m_threadTargets[k]++;
+            }
+            m_threadSeconds[k] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        });
+    }
+
+    void
+    ShortestPathTable::ComputeTarget (uint32_t target, std::vector<uint32_t> &queue)
+    {
+        //!< ISLs are bidirectional, so a search from the target gives the distance of every node to it
+        uint16_t *distance = &m_distance[(size_t) target * m_numNodes];
+        uint32_t head = 0;
+        uint32_t tail = 0;
+        distance[target] = 0;
+        queue[tail++] = target;
+        while (head < tail) {
+            uint32_t node = queue[head++];
+            for (uint32_t slot = 0; slot < m_neighbors[node].size(); ++slot) {
+                uint32_t neighbor = m_neighbors[node][slot];
+                if (((m_linkUp[node] >> slot) & 1) && distance[neighbor] == UNREACHABLE) {
+                    distance[neighbor] = distance[node] + 1;
+                    queue[tail++] = neighbor;
+                }
+            }
+        }
+        for (uint32_t node = 0; node < m_numNodes; ++node) {
+            RecomputeMask(target, node);
+        }
+    }
+
+    bool
+    ShortestPathTable::RecomputeMask (uint32_t target, uint32_t node)
+    {
+        const uint16_t *distance = &m_distance[(size_t) target * m_numNodes];
+        uint8_t *mask = &m_nextHopMask[(size_t) target * m_numNodes];
+        uint8_t bits = 0;
+        if (node != target && distance[node] != UNREACHABLE) {
+            for (uint32_t slot = 0; slot < m_neighbors[node].size(); ++slot) {
+                if (((m_linkUp[node] >> slot) & 1) &&
+                    (uint32_t) distance[m_neighbors[node][slot]] + 1 == distance[node]) {
+                    bits |= (uint8_t) (1u << slot);
+                }
+            }
+        }
+        bool changed = mask[node] != bits;
+        mask[node] = bits;
+        return changed;
+    }
+
+    void
+    ShortestPathTable::SetLinkState (uint32_t a, uint32_t b, bool up)
+    {
+        uint32_t slotA = FindSlot(a, b);
+        uint32_t slotB = FindSlot(b, a);
+        m_lastRepairedEntries = 0;
+        if (IsLinkUp(a, b) == up) {
+            return;
+        }
+        if (up) {
+            m_linkUp[a] |= (uint8_t) (1u << slotA);
+            m_linkUp[b] |= (uint8_t) (1u << slotB);
+        } else {
+            m_linkUp[a] &= (uint8_t) ~(1u << slotA);
+            m_linkUp[b] &= (uint8_t) ~(1u << slotB);
+        }
+        if (m_distance.empty()) {
+            return;
+        }
+        //!< Most targets return after two distance reads, waking the workers only pays off on large tables
+        uint32_t numThreads = m_numNodes < MIN_PARALLEL_REPAIR_NODES ? 1 : m_numThreads;
+        ParallelFor(numThreads, numThreads, [this, numThreads, a, b, up] (uint32_t k) {
+            RepairScratch &scratch = m_scratch[k];
+            uint64_t repaired = 0;
+            for (uint32_t target = k; target < m_numNodes; target += numThreads) {
+                repaired += up ? RepairLinkUp(target, a, b, scratch) : RepairLinkDown(target, a, b, scratch);
+            }
+            m_threadRepaired[k] = repaired;
+        });
+        for (uint32_t k = 0; k < numThreads; ++k) {
+            m_lastRepairedEntries += m_threadRepaired[k];
+        }
+    }
+
+    uint32_t
+    ShortestPathTable::RepairLinkDown (uint32_t target, uint32_t a, uint32_t b, RepairScratch &scratch)
+    {
+        uint16_t *distance = &m_distance[(size_t) target * m_numNodes];
+        uint8_t *mask = &m_nextHopMask[(size_t) target * m_numNodes];
+        //!< Only a link on a shortest path matters: u is the end farther from the target
+        uint32_t u;
+        uint32_t v;
+        if (distance[b] != UNREACHABLE && (uint32_t) distance[b] + 1 == distance[a]) {
+            u = a;
+            v = b;
+        } else if (distance[a] != UNREACHABLE && (uint32_t) distance[a] + 1 == distance[b]) {
+            u = b;
+            v = a;
+        } else {
+            return 0;
+        }
+        mask[u] &= (uint8_t) ~(1u << FindSlot(u, v));
+        if (mask[u] != 0) {
+            //!< another equal-cost next hop remains, no distance changes
+            return 1;
+        }
+
+        //!< Nodes left without any shortest next hop, found through the next-hop bits pointing at them
+        std::vector<uint32_t> &affected = scratch.touched;
+        affected.clear();
+        affected.push_back(u);
+        scratch.affected[u] = 1;
+        for (size_t i = 0; i < affected.size(); ++i) {
+            uint32_t x = affected[i];
+            for (uint32_t slot = 0; slot < m_neighbors[x].size(); ++slot) {
+                uint32_t w = m_neighbors[x][slot];
+                uint8_t bit = (uint8_t) (1u << m_reverseSlot[x][slot]);
+                if (!scratch.affected[w] && (mask[w] & bit)) {
+                    mask[w] &= (uint8_t) ~bit;
+                    if (mask[w] == 0) {
+                        scratch.affected[w] = 1;
+                        affected.push_back(w);
+                    }
+                }
+            }
+        }
+
+        //!< Settle the affected nodes from the unaffected ones around them
+        std::vector<DistanceNode> &heap = scratch.heap;
+        heap.clear();
+        for (uint32_t x : affected) {
+            uint32_t best = UNREACHABLE;
+            for (uint32_t slot = 0; slot < m_neighbors[x].size(); ++slot) {
+                uint32_t w = m_neighbors[x][slot];
+                if (((m_linkUp[x] >> slot) & 1) && !scratch.affected[w] && distance[w] != UNREACHABLE) {
+                    best = std::min(best, (uint32_t) distance[w] + 1);
+                }
+            }
+            distance[x] = (uint16_t) best;
+            if (best != UNREACHABLE) {
+                heap.push_back(DistanceNode(best, x));
+            }
+        }
+        std::make_heap(heap.begin(), heap.end(), std::greater<DistanceNode>());
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<DistanceNode>());
+            DistanceNode top = heap.back();
+            heap.pop_back();
+            if (top.first != distance[top.second]) {
+                continue;
+            }
+            uint32_t x = top.second;
+            for (uint32_t slot = 0; slot < m_neighbors[x].size(); ++slot) {
+                uint32_t w = m_neighbors[x][slot];
+                if (((m_linkUp[x] >> slot) & 1) && scratch.affected[w] && top.first + 1 < distance[w]) {
+                    distance[w] = (uint16_t) (top.first + 1);
+                    heap.push_back(DistanceNode(top.first + 1, w));
+                    std::push_heap(heap.begin(), heap.end(), std::greater<DistanceNode>());
+                }
+            }
+        }
+
+        //!< Masks of the affected nodes and of their neighbors
+        uint32_t repaired = 1 + affected.size();
+        for (uint32_t x : affected) {
+            scratch.affected[x] = 0;
+        }
+        for (uint32_t x : affected) {
+            RecomputeMask(target, x);
+            for (uint32_t w : m_neighbors[x]) {
+                repaired += RecomputeMask(target, w) ? 1 : 0;
+            }
+        }
+        return repaired;
+    }
+
+    uint32_t
+    ShortestPathTable::RepairLinkUp (uint32_t target, uint32_t a, uint32_t b, RepairScratch &scratch)
+    {
+        uint16_t *distance = &m_distance[(size_t) target * m_numNodes];
+        //!< At most one end gets closer, the decrease spreads breadth-first from it
+        std::vector<uint32_t> &changed = scratch.touched;
+        changed.clear();
+        uint32_t head = 0;
+        uint32_t tail = 0;
+        for (int side = 0; side < 2; ++side) {
+            uint32_t x = side == 0 ? a : b;
+            uint32_t y = side == 0 ? b : a;
+            if (distance[y] != UNREACHABLE && (uint32_t) distance[y] + 1 < distance[x]) {
+                distance[x] = (uint16_t) (distance[y] + 1);
+                scratch.queue[tail++] = x;
+                changed.push_back(x);
+            }
+        }
+        while (head < tail) {
+            uint32_t x = scratch.queue[head++];
+            for (uint32_t slot = 0; slot < m_neighbors[x].size(); ++slot) {
+                uint32_t w = m_neighbors[x][slot];
+                if (((m_linkUp[x] >> slot) & 1) && (uint32_t) distance[x] + 1 < distance[w]) {
+                    distance[w] = (uint16_t) (distance[x] + 1);
+                    scratch.queue[tail++] = w;
+                    changed.push_back(w);
+                }
+            }
+        }
+        uint32_t repaired = changed.size();
+        repaired += RecomputeMask(target, a) ? 1 : 0;
+        repaired += RecomputeMask(target, b) ? 1 : 0;
+        for (uint32_t x : changed) {
+            RecomputeMask(target, x);
+            for (uint32_t w : m_neighbors[x]) {
+                repaired += RecomputeMask(target, w) ? 1 : 0;
+            }
+        }
+        return repaired;
+    }
+
+    bool
+    ShortestPathTable::IsLinkUp (uint32_t a, uint32_t b) const
+    {
+        return (m_linkUp.at(a) >> FindSlot(a, b)) & 1;
+    }
+
+    uint64_t
+    ShortestPathTable::GetLastRepairedEntries (void) const
+    {
+        return m_lastRepairedEntries;
+    }
+
+    uint8_t
+    ShortestPathTable::GetNextHopMask (uint32_t node, uint32_t target) const
+    {
+        return m_nextHopMask[(size_t) target * m_numNodes + node];
+    }
+
+    uint16_t
+    ShortestPathTable::GetDistance (uint32_t node, uint32_t target) const
+    {
+        return m_distance[(size_t) target * m_numNodes + node];
+    }
+
+    uint32_t
+    ShortestPathTable::GetNumNodes (void) const
+    {
+        return m_numNodes;
+    }
+
+    uint32_t
+    ShortestPathTable::GetNeighbor (uint32_t node, uint32_t slot) const
+    {
+        return m_neighbors.at(node).at(slot);
+    }
+
+    const std::vector<double> &
+    ShortestPathTable::GetThreadSeconds (void) const
+    {
+        return m_threadSeconds;
+    }
+
+    const std::vector<uint32_t> &
+    ShortestPathTable::GetThreadTargets (void) const
+    {
+        return m_threadTargets;
+    }
+
+}
@@ -0,0 +1,132 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#ifndef SATELLITE_NETWORK_SHORTEST_PATH_TABLE_H
+#define SATELLITE_NETWORK_SHORTEST_PATH_TABLE_H
+
+#include "ns3/object.h"
+#include "memory-accounting.h"
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * All-pairs shortest paths (hop count) of the ISL grid, shared by all satellites.
+     *
+     * For every pair (node, target) the table keeps the hop distance and a bit mask over the
+     * neighbor slots of node whose neighbor lies on a shortest path to target, i.e. the
+     * equal-cost next hops. Both matrices are stored target-major, so each target is one
+     * contiguous row that a single thread fills by a breadth-first search from the target.
+     *
+     * When a link goes down or comes back, each row is repaired in place: only nodes whose
+     * distance to the target changes, and their neighbors, are touched (decremental update in
+     * the manner of Ramalingam and Reps for a failure, a bounded search for a recovery).
+     */
+    class ShortestPathTable : public Object
+    {
+    public:
+        static TypeId GetTypeId (void);
+
+        static const uint32_t MAX_DEGREE = 8;                 //!< neighbor slots that fit the uint8 mask
+        static const uint16_t UNREACHABLE = 0xFFFF;
+        static const uint32_t MIN_PARALLEL_REPAIR_NODES = 2048;   //!< smaller tables are repaired on the calling thread
+
+        explicit ShortestPathTable (uint32_t numNodes);
+        ~ShortestPathTable ();
+
+        /**
+         * @param node      node id
+         * @param neighbors neighbor ids, the slot of a neighbor is its bit in the next-hop mask
+         */
+        void SetNeighbors (uint32_t node, const std::vector<uint32_t> &neighbors);
+
+        /**
+         * Compute every target, targets are spread over numThreads threads.
+         * @param numThreads number of threads including the calling one
+         */
+        void Compute (uint32_t numThreads);
+
+        /**
+         * Take a link out of or back into the shortest paths and repair the affected entries,
+         * on the threads of the last Compute, or inline below MIN_PARALLEL_REPAIR_NODES.
+         * @param a   node at one end
+         * @param b   node at the other end, must be a neighbor of a
+         * @param up  whether the link works
+         */
+        void SetLinkState (uint32_t a, uint32_t b, bool up);
+
+        bool IsLinkUp (uint32_t a, uint32_t b) const;
+
+        //!< Distance and mask entries rewritten by the last SetLinkState
+        uint64_t GetLastRepairedEntries (void) const;
+
+        /**
+         * @return bit i is set if neighbor slot i of node is a shortest next hop to target
+         */
+        uint8_t GetNextHopMask (uint32_t node, uint32_t target) const;
+
+        /**
+         * @return hops from node to target, UNREACHABLE if there is no path
+         */
+        uint16_t GetDistance (uint32_t node, uint32_t target) const;
+
+        uint32_t GetNumNodes (void) const;
+        uint32_t GetNeighbor (uint32_t node, uint32_t slot) const;
+
+        //!< Wall clock seconds and number of targets of each thread in the last Compute
+        const std::vector<double> &GetThreadSeconds (void) const;
+        const std::vector<uint32_t> &GetThreadTargets (void) const;
+
+    private:
+        typedef std::pair<uint32_t, uint32_t> DistanceNode;
+
+        //!< Per-thread buffers of a repair, allocated by Compute and reused by every SetLinkState
+        struct RepairScratch {
+            std::vector<uint32_t> queue;
+            std::vector<uint32_t> touched;
+            std::vector<uint8_t> affected;
+            std::vector<DistanceNode> heap;
+        };
+
+        void ComputeTarget (uint32_t target, std::vector<uint32_t> &queue);
+        uint32_t RepairLinkDown (uint32_t target, uint32_t a, uint32_t b, RepairScratch &scratch);
+        uint32_t RepairLinkUp (uint32_t target, uint32_t a, uint32_t b, RepairScratch &scratch);
+        bool RecomputeMask (uint32_t target, uint32_t node);
+        uint32_t FindSlot (uint32_t node, uint32_t neighbor) const;
+        uint32_t m_numNodes;
+        uint32_t m_numThreads;
+        std::vector<std::vector<uint32_t>> m_neighbors;
+        std::vector<std::vector<uint32_t>> m_reverseSlot;   //!< slot of node in the list of its neighbor
+        std::vector<uint8_t> m_linkUp;                      //!< bit per neighbor slot
+        uint64_t m_lastRepairedEntries;
+        std::vector<uint16_t, AccountedAllocator<uint16_t>> m_distance;        //!< [target * N + node]
+        std::vector<uint8_t, AccountedAllocator<uint8_t>> m_nextHopMask;       //!< [target * N + node]
+        std::vector<double> m_threadSeconds;
+        std::vector<uint32_t> m_threadTargets;
+        std::vector<RepairScratch> m_scratch;
+        std::vector<uint64_t> m_threadRepaired;
+    };
+
+}
+
+#endif //SATELLITE_NETWORK_SHORTEST_PATH_TABLE_H
@@ -0,0 +1,124 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "terminal-attachment-table.h"
+#include "ns3/service-link-manager.h"
+#include "ns3/ipv4.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+    NS_LOG_COMPONENT_DEFINE ("TerminalAttachmentTable");
+    NS_OBJECT_ENSURE_REGISTERED (TerminalAttachmentTable);
+
+    TypeId
+    TerminalAttachmentTable::GetTypeId (void)
+    {
+        static TypeId tid = TypeId ("ns3::TerminalAttachmentTable")
+                .SetParent<Object> ()
+                .SetGroupName("RoutingRL")
+        ;
+        return tid;
+    }
+
+    TerminalAttachmentTable::TerminalAttachmentTable (Ptr<TopologySatellite> topology, NodeContainer nodes, Time ttl)
+    {
+        m_topology = topology;
+        m_nodes = nodes;
+        m_ttl = ttl;
+        m_fills = 0;
+        m_pushes = 0;
+        m_isTerminal = std::vector<uint8_t>(nodes.GetN(), 0);
+        m_entries = std::vector<Attachment>(nodes.GetN(), Attachment{-1, UNKNOWN, 0, std::numeric_limits<int64_t>::min()});
+        for (uint32_t node = 0; node < nodes.GetN(); ++node) {
+            m_isTerminal[node] = topology->IsUserTerminalId(node) ? 1 : 0;
+        }
+    }
+
+    TerminalAttachmentTable::~TerminalAttachmentTable ()
+    {
+    }
+
+    void
+    TerminalAttachmentTable::DoDispose (void)
+    {
+        //!< Aggregated to the topology it points to, break the cycle
+        m_topology = nullptr;
+        m_nodes = NodeContainer();
+        Object::DoDispose();
+    }
+
+    void
+    TerminalAttachmentTable::Fill (uint32_t terminal)
+    {
+        NS_ASSERT(m_isTerminal[terminal]);
+        Attachment &entry = m_entries[terminal];
+        entry.satellite = m_topology->GetUserTerminal(m_topology->NodeToUserTerminalId(terminal))->GetSatelliteNode()->GetId();
+        entry.ifIndex = UNKNOWN;
+        entry.validUntilNs = (Simulator::Now() + m_ttl).GetNanoSeconds();
+        m_fills++;
+    }
+
+    const TerminalAttachmentTable::Attachment &
+    TerminalAttachmentTable::GetDelivery (uint32_t terminal, Ptr<ServiceLinkManager> manager)
+    {
+        Attachment &entry = m_entries[terminal];
+        if (entry.validUntilNs <= Simulator::Now().GetNanoSeconds()) {
+            Fill(terminal);
+        }
+        if (entry.ifIndex == UNKNOWN) {
+            //!< Service link device of the terminal at this satellite, and the terminal side of the link
+            entry.ifIndex = m_topology->GetServiceLinkNetDevices().Get(manager->GetServiceLinkDeviceId(terminal))->GetIfIndex();
+            uint32_t terminal_if_idx = m_topology->GetServiceLinkNetDevices().Get(
+                    terminal - m_topology->GetNumSatellites() + m_topology->GetNumSatellites() * m_topology->GetCapacity())->GetIfIndex();
+            entry.gateway = m_nodes.Get(terminal)->GetObject<Ipv4>()->GetAddress(terminal_if_idx, 0).GetLocal().Get();
+        }
+        return entry;
+    }
+
+    void
+    TerminalAttachmentTable::Attach (uint32_t terminal, uint32_t satellite, uint32_t ifIndex, uint32_t gateway)
+    {
+        NS_ASSERT(m_isTerminal.at(terminal));
+        m_entries[terminal] = Attachment{(int32_t) satellite, ifIndex, gateway, std::numeric_limits<int64_t>::max()};
+        m_pushes++;
+    }
+
+    void
+    TerminalAttachmentTable::Detach (uint32_t terminal)
+    {
+        m_entries.at(terminal).validUntilNs = std::numeric_limits<int64_t>::min();
+    }
+
+    uint64_t
+    TerminalAttachmentTable::GetNumFills (void) const
+    {
+        return m_fills;
+    }
+
+    uint64_t
+    TerminalAttachmentTable::GetNumPushes (void) const
+    {
+        return m_pushes;
+    }
+
+}
@@ -0,0 +1,127 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#ifndef SATELLITE_NETWORK_TERMINAL_ATTACHMENT_TABLE_H
+#define SATELLITE_NETWORK_TERMINAL_ATTACHMENT_TABLE_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/topology-satellites.h"
+#include <limits>
+#include <vector>
+
+namespace ns3 {
+
+    class ServiceLinkManager;
+
+    /**
+     * Dense table, indexed by node id, of the satellite serving each user terminal and of what
+     * the serving satellite needs to deliver to it (its service link interface and the address
+     * of the terminal), shared by all arbiters through the topology.
+     *
+     * Handover code pushes an attachment with Attach() when a terminal changes satellite, a
+     * pushed entry is trusted until the next push. A terminal nobody pushed is read from the
+     * topology on first use and kept for the time to live, which bounds how long a handover
+     * that was not pushed can go unnoticed. A zero time to live reads the topology on every lookup.
+     */
+    class TerminalAttachmentTable : public Object
+    {
+    public:
+        static TypeId GetTypeId (void);
+
+        static const uint32_t UNKNOWN = std::numeric_limits<uint32_t>::max();
+
+        struct Attachment {
+            int32_t satellite;      //!< serving satellite, -1 if not resolved
+            uint32_t ifIndex;       //!< service link interface at the serving satellite, UNKNOWN if not resolved
+            uint32_t gateway;       //!< address of the terminal on its service link
+            int64_t validUntilNs;   //!< simulation time the entry expires, max for pushed entries
+        };
+
+        /**
+         * @param topology  topology holding the user terminals
+         * @param nodes     all nodes, indexed by node id
+         * @param ttl       time to live of entries read from the topology, zero to read through
+         */
+        TerminalAttachmentTable (Ptr<TopologySatellite> topology, NodeContainer nodes, Time ttl);
+        ~TerminalAttachmentTable ();
+
+        bool IsTerminal (uint32_t node) const
+        {
+            return m_isTerminal[node];
+        }
+
+        /**
+         * @return node id of the satellite serving a terminal
+         */
+        int32_t GetServingSatellite (uint32_t terminal)
+        {
+            Attachment &entry = m_entries[terminal];
+            if (entry.validUntilNs <= Simulator::Now().GetNanoSeconds()) {
+                Fill(terminal);
+            }
+            return entry.satellite;
+        }
+
+        /**
+         * Attachment of a terminal served by the calling satellite, with the delivery fields resolved.
+         * @param terminal  node id of the terminal
+         * @param manager   service link manager of the serving satellite
+         */
+        const Attachment &GetDelivery (uint32_t terminal, Ptr<ServiceLinkManager> manager);
+
+        /**
+         * Push the attachment of a terminal after a handover.
+         * @param terminal  node id of the terminal
+         * @param satellite node id of the new serving satellite
+         * @param ifIndex   service link interface at that satellite
+         * @param gateway   address of the terminal on its service link
+         */
+        void Attach (uint32_t terminal, uint32_t satellite, uint32_t ifIndex, uint32_t gateway);
+
+        /**
+         * Forget a terminal, the next lookup reads it from the topology again.
+         */
+        void Detach (uint32_t terminal);
+
+        uint64_t GetNumFills (void) const;
+        uint64_t GetNumPushes (void) const;
+
+    protected:
+        virtual void DoDispose (void);
+
+    private:
+        void Fill (uint32_t terminal);
+        Ptr<TopologySatellite> m_topology;
+        NodeContainer m_nodes;
+        Time m_ttl;
+        std::vector<uint8_t> m_isTerminal;
+        std::vector<Attachment> m_entries;
+        uint64_t m_fills;
+        uint64_t m_pushes;
+    };
+
+}
+
+#endif //SATELLITE_NETWORK_TERMINAL_ATTACHMENT_TABLE_H
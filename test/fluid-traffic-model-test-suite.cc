@@ -0,0 +1,97 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "ns3/test.h"
+#include "ns3/fluid-traffic-model.h"
+#include "ns3/shortest-path-table.h"
+
+using namespace ns3;
+
+/**
+ * A fluid flow along an ISL that goes down moves to another shortest path, and the queue of the
+ * ISL it left reads full since the ISL has no capacity anymore.
+ */
+class FluidTrafficModelLinkDownTestCase : public TestCase
+{
+public:
+    FluidTrafficModelLinkDownTestCase ();
+
+private:
+    virtual void DoRun (void);
+};
+
+FluidTrafficModelLinkDownTestCase::FluidTrafficModelLinkDownTestCase ()
+    : TestCase ("Fluid queue of an ISL taken down grows and its flow moves")
+{
+}
+
+void
+FluidTrafficModelLinkDownTestCase::DoRun (void)
+{
+    //!< 4 orbits of 4 satellites, north, south, west, east as in the satellites
+    const uint32_t numOrbits = 4;
+    const uint32_t satellitesPerOrbit = 4;
+    Ptr<ShortestPathTable> shortestPaths = CreateObject<ShortestPathTable>(numOrbits * satellitesPerOrbit);
+    for (uint32_t orbit = 0; orbit < numOrbits; ++orbit) {
+        for (uint32_t i = 0; i < satellitesPerOrbit; ++i) {
+            shortestPaths->SetNeighbors(orbit * satellitesPerOrbit + i, {
+                    orbit * satellitesPerOrbit + (i + 1) % satellitesPerOrbit,
+                    orbit * satellitesPerOrbit + (i + satellitesPerOrbit - 1) % satellitesPerOrbit,
+                    ((orbit + numOrbits - 1) % numOrbits) * satellitesPerOrbit + i,
+                    ((orbit + 1) % numOrbits) * satellitesPerOrbit + i
+            });
+        }
+    }
+    shortestPaths->Compute(1);
+
+    //!< 8 Mbit/s over 10 Mbit/s ISLs from satellite 0 to 2, two hops north or south
+    Ptr<FluidTrafficModel> fluidTraffic = CreateObject<FluidTrafficModel>(nullptr, shortestPaths, 10e6, 10e6, 100, 1500);
+    fluidTraffic->AddFlow(0, 2, 8e6, 0, 1000000000);
+    fluidTraffic->Update();
+    NS_TEST_ASSERT_MSG_EQ_TOL (fluidTraffic->GetLoad(0, 0), 8e6, 1.0, "Flow takes the first shortest next hop, north");
+    NS_TEST_ASSERT_MSG_EQ_TOL (fluidTraffic->GetQueueEstimate(0, 0), 0.8 * 0.8 / (2.0 * 0.2), 1e-9, "M/D/1 queue at 80 % load");
+
+    shortestPaths->SetLinkState(0, 1, false);
+    fluidTraffic->Update();
+    NS_TEST_ASSERT_MSG_EQ_TOL (fluidTraffic->GetLoad(0, 0), 0.0, 1.0, "No load on the ISL that is down");
+    NS_TEST_ASSERT_MSG_EQ_TOL (fluidTraffic->GetLoad(0, 1), 8e6, 1.0, "Flow moves south");
+    NS_TEST_ASSERT_MSG_EQ_TOL (fluidTraffic->GetQueueEstimate(0, 0), 100.0, 1e-9, "Queue of the ISL that is down reads full");
+
+    shortestPaths->SetLinkState(0, 1, true);
+    fluidTraffic->Update();
+    NS_TEST_ASSERT_MSG_EQ_TOL (fluidTraffic->GetQueueEstimate(0, 1), 0.0, 1e-9, "Flow back north once the ISL is up");
+    fluidTraffic->Dispose();
+}
+
+class FluidTrafficModelTestSuite : public TestSuite
+{
+public:
+    FluidTrafficModelTestSuite ();
+};
+
+FluidTrafficModelTestSuite::FluidTrafficModelTestSuite ()
+    : TestSuite ("satellite-network-fluid-traffic-model", UNIT)
+{
+    AddTestCase (new FluidTrafficModelLinkDownTestCase, TestCase::QUICK);
+}
+
+static FluidTrafficModelTestSuite g_fluidTrafficModelTestSuite;
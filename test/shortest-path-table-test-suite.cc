@@ -0,0 +1,131 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2024 SJTU China
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: HaiLong Su
+ *
+ */
+
+
+#include "ns3/test.h"
+#include "ns3/shortest-path-table.h"
+#include <random>
+#include <string>
+
+using namespace ns3;
+
+/**
+ * Random link failures and recoveries on a +Grid, the incrementally repaired table
+ * must equal a table computed from scratch with the same links.
+ */
+class ShortestPathTableRepairTestCase : public TestCase
+{
+public:
+    ShortestPathTableRepairTestCase (uint32_t numOrbits, uint32_t satellitesPerOrbit, uint32_t numEvents, uint32_t checkInterval);
+
+private:
+    virtual void DoRun (void);
+    void SetGrid (Ptr<ShortestPathTable> table);
+    void CheckEqual (Ptr<ShortestPathTable> repaired, Ptr<ShortestPathTable> reference, uint32_t event);
+
+    uint32_t m_numOrbits;
+    uint32_t m_satellitesPerOrbit;
+    uint32_t m_numEvents;
+    uint32_t m_checkInterval;
+};
+
+ShortestPathTableRepairTestCase::ShortestPathTableRepairTestCase (uint32_t numOrbits, uint32_t satellitesPerOrbit,
+                                                                  uint32_t numEvents, uint32_t checkInterval)
+    : TestCase ("Repair after " + std::to_string(numEvents) + " random link events on a " +
+                std::to_string(numOrbits) + "x" + std::to_string(satellitesPerOrbit) + " grid equals a full recompute"),
+      m_numOrbits(numOrbits),
+      m_satellitesPerOrbit(satellitesPerOrbit),
+      m_numEvents(numEvents),
+      m_checkInterval(checkInterval)
+{
+}
+
+void
+ShortestPathTableRepairTestCase::SetGrid (Ptr<ShortestPathTable> table)
+{
+    //!< north, south, west, east as in the satellites
+    for (uint32_t orbit = 0; orbit < m_numOrbits; ++orbit) {
+        for (uint32_t i = 0; i < m_satellitesPerOrbit; ++i) {
+            std::vector<uint32_t> neighbors = {
+                    orbit * m_satellitesPerOrbit + (i + 1) % m_satellitesPerOrbit,
+                    orbit * m_satellitesPerOrbit + (i + m_satellitesPerOrbit - 1) % m_satellitesPerOrbit,
+                    ((orbit + m_numOrbits - 1) % m_numOrbits) * m_satellitesPerOrbit + i,
+                    ((orbit + 1) % m_numOrbits) * m_satellitesPerOrbit + i
+            };
+            table->SetNeighbors(orbit * m_satellitesPerOrbit + i, neighbors);
+        }
+    }
+}
+
+void
+ShortestPathTableRepairTestCase::CheckEqual (Ptr<ShortestPathTable> repaired, Ptr<ShortestPathTable> reference, uint32_t event)
+{
+    for (uint32_t node = 0; node < repaired->GetNumNodes(); ++node) {
+        for (uint32_t target = 0; target < repaired->GetNumNodes(); ++target) {
+            NS_TEST_ASSERT_MSG_EQ (repaired->GetDistance(node, target), reference->GetDistance(node, target),
+                                   "Distance of " << node << " to " << target << " after event " << event);
+            NS_TEST_ASSERT_MSG_EQ ((uint32_t) repaired->GetNextHopMask(node, target), (uint32_t) reference->GetNextHopMask(node, target),
+                                   "Next hops of " << node << " to " << target << " after event " << event);
+        }
+    }
+}
+
+void
+ShortestPathTableRepairTestCase::DoRun (void)
+{
+    uint32_t numNodes = m_numOrbits * m_satellitesPerOrbit;
+    Ptr<ShortestPathTable> repaired = CreateObject<ShortestPathTable>(numNodes);
+    Ptr<ShortestPathTable> reference = CreateObject<ShortestPathTable>(numNodes);
+    SetGrid(repaired);
+    SetGrid(reference);
+    repaired->Compute(3);
+    reference->Compute(1);
+
+    std::mt19937 rng(5);
+    for (uint32_t event = 1; event <= m_numEvents; ++event) {
+        uint32_t a = rng() % numNodes;
+        uint32_t b = repaired->GetNeighbor(a, rng() % 4);
+        //!< Even events mostly take a link down, odd ones flip it
+        bool up = event % 2 == 0 ? (rng() % 4 == 0) : !repaired->IsLinkUp(a, b);
+        repaired->SetLinkState(a, b, up);
+        reference->SetLinkState(a, b, up);
+        if (event % m_checkInterval == 0 || event == m_numEvents) {
+            reference->Compute(1);
+            CheckEqual(repaired, reference, event);
+        }
+    }
+}
+
+class ShortestPathTableTestSuite : public TestSuite
+{
+public:
+    ShortestPathTableTestSuite ();
+};
+
+ShortestPathTableTestSuite::ShortestPathTableTestSuite ()
+    : TestSuite ("satellite-network-shortest-path-table", UNIT)
+{
+    //!< Below MIN_PARALLEL_REPAIR_NODES the repair runs inline, above it on the workers
+    AddTestCase (new ShortestPathTableRepairTestCase (24, 12, 3000, 50), TestCase::QUICK);
+    AddTestCase (new ShortestPathTableRepairTestCase (48, 45, 200, 50), TestCase::EXTENSIVE);
+}
+
+static ShortestPathTableTestSuite g_shortestPathTableTestSuite;